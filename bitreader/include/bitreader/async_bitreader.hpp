@@ -0,0 +1,291 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "bitreader/bitreader.hpp"
+
+namespace brcpp {
+
+    //--------------------------------------------------------------------------
+    template<typename T>
+    class parse_task;
+
+    namespace detail {
+        //----------------------------------------------------------------------
+        struct parse_promise_base {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+                void await_resume() noexcept {}
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+                {
+                    // Hand control back to the task awaiting this one, if any
+                    auto next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+            };
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            final_awaiter final_suspend() noexcept { return {}; }
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        //----------------------------------------------------------------------
+        template<typename T>
+        struct parse_promise: parse_promise_base {
+            std::optional<T> value;
+
+            parse_task<T> get_return_object();
+            void return_value(T v) { value = std::move(v); }
+
+            T result()
+            {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*value);
+            }
+        };
+
+        //----------------------------------------------------------------------
+        template<>
+        struct parse_promise<void>: parse_promise_base {
+            parse_task<void> get_return_object();
+            void return_void() {}
+
+            void result()
+            {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Coroutine type for parsers built on async_bitreader.
+     *
+     * The coroutine starts running immediately and runs until it needs data
+     * that has not arrived yet. Tasks can co_await other tasks, so nested
+     * structures can be parsed by nested coroutines.
+     */
+    template<typename T = void>
+    class parse_task {
+    public:
+        using promise_type = detail::parse_promise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        explicit parse_task(handle_type handle): _handle(handle) {}
+        parse_task(parse_task&& other) noexcept: _handle(std::exchange(other._handle, {})) {}
+        parse_task(const parse_task&) = delete;
+        parse_task& operator=(const parse_task&) = delete;
+
+        ~parse_task()
+        {
+            if (_handle) {
+                _handle.destroy();
+            }
+        }
+
+        /**
+         * @return Whether the parser has finished (successfully or not)
+         */
+        bool done() const
+        {
+            return _handle.done();
+        }
+
+        /**
+         * @return The parse result; rethrows the exception the parser failed with
+         */
+        T get()
+        {
+            if (!done()) {
+                throw std::logic_error("Parse task is still waiting for data");
+            }
+            return _handle.promise().result();
+        }
+
+        //----------------------------------------------------------------------
+        bool await_ready() const noexcept
+        {
+            return _handle.done();
+        }
+
+        void await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            _handle.promise().continuation = awaiting;
+        }
+
+        T await_resume()
+        {
+            return _handle.promise().result();
+        }
+
+    private:
+        handle_type _handle;
+    };
+
+    namespace detail {
+        //----------------------------------------------------------------------
+        template<typename T>
+        parse_task<T> parse_promise<T>::get_return_object()
+        {
+            return parse_task<T>(std::coroutine_handle<parse_promise<T>>::from_promise(*this));
+        }
+
+        //----------------------------------------------------------------------
+        inline parse_task<void> parse_promise<void>::get_return_object()
+        {
+            return parse_task<void>(std::coroutine_handle<parse_promise<void>>::from_promise(*this));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Suspendable front end to bitreader.
+     *
+     * Reads are awaitable: instead of throwing need_more_data they suspend
+     * the calling parse_task until resume() finds enough data in the source.
+     * Once the source is depleted, reads behave exactly like bitreader ones.
+     */
+    template<byte_source Source>
+    class async_bitreader {
+    public:
+        explicit async_bitreader(std::shared_ptr<Source> source)
+            : _source(source)
+            , _reader(source)
+        {
+        }
+
+        async_bitreader(const async_bitreader&) = delete;
+        async_bitreader& operator=(const async_bitreader&) = delete;
+
+        /**
+         * @return The synchronous reader, e.g. for codecs after ensure()
+         */
+        bitreader<Source>& reader()
+        {
+            return _reader;
+        }
+
+        size_t position() const
+        {
+            return _reader.position();
+        }
+
+        /**
+         * @return Whether a parser is suspended waiting for data
+         */
+        bool waiting() const
+        {
+            return static_cast<bool>(_waiting);
+        }
+
+        /**
+         * @brief Resume the suspended parser if its data has arrived.
+         *        To be called after new data is pushed into the source.
+         * @return Whether the parser has been resumed
+         */
+        bool resume()
+        {
+            if (!_waiting || !_ready(_wanted)) {
+                return false;
+            }
+
+            std::exchange(_waiting, {}).resume();
+            return true;
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Wait until the given number of bits can be read without
+         *        suspending (or the source is depleted)
+         */
+        auto ensure(size_t bits)
+        {
+            return _await<void>(bits, [] (async_bitreader&) {});
+        }
+
+        //----------------------------------------------------------------------
+        template<bit_readable T>
+        auto read(size_t bits)
+        {
+            return _await<T>(bits, [bits] (async_bitreader& self) {
+                return self._reader.template read<T>(bits);
+            });
+        }
+
+        //----------------------------------------------------------------------
+        template<enumeration T>
+        auto read(size_t bits)
+        {
+            return _await<T>(bits, [bits] (async_bitreader& self) {
+                return self._reader.template read<T>(bits);
+            });
+        }
+
+        //----------------------------------------------------------------------
+        auto skip(size_t bits)
+        {
+            return _await<void>(bits, [bits] (async_bitreader& self) {
+                self._reader.skip(bits);
+            });
+        }
+
+    private:
+        //----------------------------------------------------------------------
+        template<typename T, typename Action>
+        struct awaiter {
+            async_bitreader& self;
+            size_t bits;
+            Action action;
+
+            bool await_ready()
+            {
+                return self._ready(bits);
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                if (self._waiting) {
+                    throw std::logic_error("Only one parser can wait on a reader");
+                }
+                self._waiting = handle;
+                self._wanted = bits;
+            }
+
+            T await_resume()
+            {
+                return action(self);
+            }
+        };
+
+        template<typename T, typename Action>
+        awaiter<T, Action> _await(size_t bits, Action action)
+        {
+            return awaiter<T, Action>{*this, bits, std::move(action)};
+        }
+
+        //----------------------------------------------------------------------
+        bool _ready(size_t bits)
+        {
+            return _reader.available() >= bits || _source->depleted();
+        }
+
+        std::shared_ptr<Source> _source;
+        bitreader<Source> _reader;
+        std::coroutine_handle<> _waiting;
+        size_t _wanted = 0;
+    };
+}
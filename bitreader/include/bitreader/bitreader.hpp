@@ -1,13 +1,18 @@
 #pragma once
+#include <algorithm>
 #include <bit>
 #include <cstdint>
 #include <cstddef>
 #include <cassert>
 #include <concepts>
+#include <cstring>
 #include <stdexcept>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include "bitreader/bitreader-utils.hpp"
+#include "common/byte_scan.hpp"
 #include "common/numeric.hpp"
 #include "data_source/byte_source.hpp"
 
@@ -21,11 +26,17 @@ namespace brcpp {
         bitreader(std::shared_ptr<Source> source)
         {
             _state.source = source;
+            _state.position = source->position();
+            if constexpr (bit_sized_byte_source<Source>) {
+                _end = source->bit_size();
+            }
             _next(_state);
         }
 
         bitreader(const bitreader&) = delete;
         bitreader& operator=(const bitreader&) = delete;
+        bitreader(bitreader&&) = default;
+        bitreader& operator=(bitreader&&) = default;
 
         /**
          * @return Current position in the input stream (in bits)
@@ -49,10 +60,15 @@ namespace brcpp {
          */
         void seek(size_t bitpos)
         {
+            if (bitpos < _begin || bitpos > _end) {
+                throw std::range_error("Cannot seek outside of the reader range");
+            }
+
             uint64_t byte_pos = bitpos / 8;
             uint64_t bits_to_skip = bitpos % 8;
 
             _state.source->seek(byte_pos);
+            _state.position = byte_pos;
             _state.shift = 0;
             _skip(_state, bits_to_skip);
         }
@@ -128,23 +144,183 @@ namespace brcpp {
             return _sign_extend(ret, bits);
         }
 
+        //----------------------------------------------------------------------
+        /**
+         * @brief Create a reader limited to the next `bits` bits, e.g. for
+         *        the payload of a box or a TLV record. skip(bits) moves this
+         *        reader past it. Positions are shared with this reader,
+         *        i.e. relative to the whole stream.
+         *
+         * A random access source is shared with this reader, nothing is
+         * cloned or reopened; each of them seeks the source back to where
+         * it left it when it needs more data, so they can be read in turns,
+         * but not concurrently. Any other source may drop data the child
+         * still needs once this reader moves on, so the child reads from a
+         * clone instead, with the limits of the source's clones (e.g. a
+         * pipe_byte_source clone cannot fall behind by more than the
+         * look-behind, a stream_byte_source clone only sees the data
+         * pushed before it was made).
+         */
+        bitreader subreader(size_t bits)
+        {
+            const size_t begin = position();
+            if (bits > _end - begin) {
+                throw std::range_error("Subreader exceeds the reader range");
+            }
+
+            if constexpr (random_access_byte_source<Source>) {
+                return bitreader(_state, begin, begin + bits);
+            } else {
+                return bitreader(_state.clone(), begin, begin + bits);
+            }
+        }
+
+        /**
+         * @return Position the reader cannot go past (in bits)
+         */
+        size_t end() const
+        {
+            return _end;
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Advance to the next occurrence of a byte pattern, e.g. an
+         *        Annex B start code. The search starts at the current
+         *        position rounded up to a whole byte.
+         * @return Bit position of the match, where the reader is left;
+         *         std::nullopt if there is none, with the reader left where
+         *         a match could still start once more data arrives
+         */
+        std::optional<size_t> find_bytes(const uint8_t* pattern, size_t size)
+        {
+            if (size == 0) {
+                throw std::invalid_argument("Empty search pattern");
+            }
+
+            const uint64_t from = (position() + 7) / 8;
+            return _scan(size - 1, [=] (const uint8_t* begin, const uint8_t* end, uint64_t offset)
+                    -> std::optional<size_t> {
+                auto skip = static_cast<size_t>(std::min<uint64_t>(
+                        from - std::min(from, offset),
+                        static_cast<uint64_t>(end - begin)));
+                auto found = brcpp::find_bytes(begin + skip, end, pattern, size);
+                if (found == end) {
+                    return std::nullopt;
+                }
+                return (offset + static_cast<uint64_t>(found - begin)) * 8;
+            });
+        }
+
+        /**
+         * @brief Advance to the next byte-aligned sync byte that repeats
+         *        with the given period, e.g. find_sync(0x47, 188, 3) for
+         *        MPEG-TS packets
+         * @param repeats Number of consecutive sync bytes to confirm
+         * @return Same as find_bytes()
+         */
+        std::optional<size_t> find_sync(uint8_t sync, size_t period, size_t repeats)
+        {
+            if (period == 0 || repeats == 0) {
+                throw std::invalid_argument("Invalid sync period");
+            }
+
+            const uint64_t from = (position() + 7) / 8;
+            const size_t span = (repeats - 1) * period;
+            return _scan(span, [=] (const uint8_t* begin, const uint8_t* end, uint64_t offset)
+                    -> std::optional<size_t> {
+                auto size = static_cast<size_t>(end - begin);
+                auto current = begin + std::min<uint64_t>(from - std::min(from, offset), size);
+                while (size - static_cast<size_t>(current - begin) > span) {
+                    current = brcpp::find_bytes(current, end - span, &sync, 1);
+                    if (current == end - span) {
+                        break;
+                    }
+
+                    size_t confirmed = 1;
+                    while (confirmed < repeats && current[confirmed * period] == sync) {
+                        ++confirmed;
+                    }
+
+                    if (confirmed == repeats) {
+                        return (offset + static_cast<uint64_t>(current - begin)) * 8;
+                    }
+                    ++current;
+                }
+                return std::nullopt;
+            });
+        }
+
+        /**
+         * @brief Advance to the next occurrence of a sync word at any bit
+         *        alignment, e.g. find_bits(0xFFF, 12) for MPEG audio frames
+         * @param bits Length of the sync word, up to 56 bits
+         * @return Same as find_bytes()
+         */
+        std::optional<size_t> find_bits(uint64_t word, size_t bits)
+        {
+            if (bits == 0 || bits > 56) {
+                throw std::invalid_argument("Sync word must be 1 to 56 bits long");
+            }
+
+            const size_t from = position();
+            const uint64_t mask = _mask<uint64_t>(bits);
+            word &= mask;
+
+            return _scan((bits + 6) / 8, [=] (const uint8_t* begin, const uint8_t* end, uint64_t offset)
+                    -> std::optional<size_t> {
+                // Every byte completes eight candidate words, test them
+                // all against the accumulator at once
+                uint64_t acc = 0;
+                auto size = static_cast<size_t>(end - begin);
+                for (size_t iter = 0; iter < size; ++iter) {
+                    acc = (acc << 8) | begin[iter];
+                    const size_t total = (iter + 1) * 8;
+                    for (size_t shift = 8; shift-- > 0;) {
+                        if (total - shift < bits || ((acc >> shift) & mask) != word) {
+                            continue;
+                        }
+
+                        size_t found = offset * 8 + total - shift - bits;
+                        if (found >= from) {
+                            return found;
+                        }
+                    }
+                }
+                return std::nullopt;
+            });
+        }
+
     private:
+        static constexpr const size_t ScanChunk = 4096;
+        static constexpr const size_t Unbounded = ~size_t(0);
+
         //----------------------------------------------------------------------
         struct internal_state {
             uint64_t buffer = 0;
             size_t shift = 0;
             std::shared_ptr<Source> source;
+            uint64_t position = 0;  // of the source, as this reader left it
 
             internal_state clone()
             {
                 return internal_state{
                     buffer,
                     shift,
-                    source->clone()
+                    source->clone(),
+                    position
                 };
             }
         };
 
+        //----------------------------------------------------------------------
+        bitreader(internal_state state, size_t begin, size_t end)
+            : _state(std::move(state))
+            , _begin(begin)
+            , _end(end)
+        {
+        }
+
         //----------------------------------------------------------------------
         template<bit_readable T>
         T _sign_extend(T raw, size_t bits)
@@ -160,23 +336,48 @@ namespace brcpp {
             }
         }
 
+        //----------------------------------------------------------------------
+        void _sync(const internal_state& state) const
+        {
+            // A subreader sharing the source may have moved it
+            if (state.source->position() != state.position) {
+                state.source->seek(state.position);
+            }
+        }
+
         //----------------------------------------------------------------------
         void _next(internal_state& state) const
         {
+            _sync(state);
             size_t available = std::min<uint64_t>(
                     sizeof(state.buffer),
                     state.source->available());
 
             size_t to_read = available;
             size_t done_read = state.source->get_n(state.buffer, to_read);
+            state.position += done_read;
             state.shift = 8 * done_read;
         }
 
         //----------------------------------------------------------------------
         void _skip(internal_state& state, size_t bits) const
         {
-            if (_available(state) < bits) {
-                throw std::runtime_error("Cannot skip beyond end of bitstream");
+            const bool held = bits < state.shift && bits <= _end - _position(state);
+            if (!held && _available(state) < bits) {
+                if constexpr (lazy_byte_source<Source>) {
+                    // The source may well have more than it reports, let it
+                    // decide whether the target position exists
+                    if (bits > state.shift && bits <= _end - _position(state)) {
+                        size_t to_skip = bits - state.shift;
+                        state.source->skip(to_skip / 8);
+                        state.position += to_skip / 8;
+                        state.shift = 0;
+                        _next(state);
+                        _skip(state, to_skip % 8);
+                        return;
+                    }
+                }
+                _underflow(state, bits, "Cannot skip beyond end of bitstream");
             }
 
             if (bits < state.shift) {
@@ -187,6 +388,7 @@ namespace brcpp {
                 size_t to_skip = bits - state.shift;
                 state.shift = 0;
                 state.source->skip(to_skip / 8);
+                state.position += to_skip / 8;
                 _next(state);
                 state.shift -= to_skip % 8;
             }
@@ -195,13 +397,27 @@ namespace brcpp {
         //----------------------------------------------------------------------
         size_t _position(const internal_state& state) const
         {
-            return state.source->position() * 8 - state.shift;
+            return state.position * 8 - state.shift;
         }
 
         //----------------------------------------------------------------------
         size_t _available(const internal_state& state) const
         {
-            return state.source->available() * 8 + state.shift;
+            _sync(state);
+            const size_t available = state.source->available() * 8 + state.shift;
+            return std::min(available, _end - _position(state));
+        }
+
+        //----------------------------------------------------------------------
+        [[noreturn]] void _underflow(const internal_state& state, size_t bits, const char* message) const
+        {
+            // The state is left untouched, so a source that is merely
+            // waiting for more data lets the caller retry the operation
+            if (!state.source->depleted() && bits <= _end - _position(state)) {
+                throw need_more_data(message);
+            }
+
+            throw std::runtime_error(message);
         }
 
         //----------------------------------------------------------------------
@@ -241,8 +457,11 @@ namespace brcpp {
         template<typename T>
         void _read(internal_state& state, size_t bits, T& ret) const
         {
-            if (_available(state) < bits) {
-                throw std::runtime_error("Cannot read beyond the bitstream data");
+            // Bits already held need nothing from the source, which might
+            // have to wait for more input to answer
+            const bool held = bits <= state.shift && bits <= _end - _position(state);
+            if (!held && _available(state) < bits) {
+                _underflow(state, bits, "Cannot read beyond the bitstream data");
             }
 
             if (bits < state.shift) {
@@ -259,10 +478,71 @@ namespace brcpp {
             }
         }
 
+        //----------------------------------------------------------------------
+        template<typename Match>
+        std::optional<size_t> _scan(size_t overlap, Match match)
+        {
+            // Only whole bytes within the reader range are scanned
+            const size_t from = position();
+            const uint64_t start = from / 8;
+            const uint64_t last = _end / 8;
+            uint64_t resume = start;
+
+            if constexpr (contiguous_byte_source<Source>) {
+                const uint8_t* data = _state.source->data();
+                const uint64_t size = std::min(_state.source->size(), last);
+                if (auto found = match(data + start, data + size, start)) {
+                    seek(*found);
+                    return found;
+                }
+                resume = size - std::min<uint64_t>(size, overlap);
+            } else {
+                // Chunks are read from one clone of the source, consecutive
+                // chunks overlap so that matches across them are not missed
+                auto source = _state.source->clone();
+                source->seek(start);
+
+                std::vector<uint8_t> chunk(ScanChunk + overlap);
+                uint64_t base = start;
+                size_t kept = 0;
+                while (true) {
+                    size_t filled = kept;
+                    while (filled < chunk.size() && base + filled < last && source->available() > 0) {
+                        uint64_t buf = 0;
+                        auto got = source->get_n(buf, static_cast<size_t>(std::min<uint64_t>({
+                                std::min<size_t>(8, chunk.size() - filled),
+                                last - base - filled,
+                                source->available()})));
+                        for (size_t iter = got; iter > 0; --iter) {
+                            chunk[filled++] = static_cast<uint8_t>(buf >> (8 * (iter - 1)));
+                        }
+                    }
+
+                    if (auto found = match(chunk.data(), chunk.data() + filled, base)) {
+                        seek(*found);
+                        return found;
+                    }
+
+                    kept = std::min(filled, overlap);
+                    if (filled < chunk.size()) {
+                        resume = base + filled - kept;
+                        break;
+                    }
+
+                    std::memmove(chunk.data(), chunk.data() + filled - kept, kept);
+                    base += filled - kept;
+                }
+            }
+
+            seek(std::max<size_t>(from, static_cast<size_t>(resume * 8)));
+            return std::nullopt;
+        }
+
         //----------------------------------------------------------------------
         template<typename T>
         void _peek(internal_state& state, size_t bits, T& ret) const
         {
+            _sync(state);
             internal_state temporary = state.clone();
             _read(temporary, bits, ret);
         }
@@ -286,6 +566,8 @@ namespace brcpp {
         }
 
         internal_state _state;
+        size_t _begin = 0;
+        size_t _end = Unbounded;
     };
 
 }
@@ -1,20 +1,44 @@
 #pragma once
+#include <algorithm>
 #include <bit>
 #include <cstdint>
 #include <cstddef>
 #include <cassert>
 #include <stdexcept>
+#include <cstring>
 #include <memory>
 #include <deque>
+#include <span>
+#include <type_traits>
 
 #include "bitreader-utils.hpp"
+#include "common/byte_scan.hpp"
 #include "common/numeric.hpp"
+#include "data_sink/byte_sink.hpp"
 
 namespace brcpp {
     //--------------------------------------------------------------------------
-    template<typename Sink>
+    /**
+     * @brief Writes bit fields MSB-first into a sink.
+     *
+     * Plain sinks get every byte through put() as soon as it is complete.
+     * Contiguous sinks get whole 64-bit words stored straight into their
+     * window instead, so their output is only complete after flush().
+     * Sinks that can change earlier output also let a field be reserved
+     * and filled in later with patch(), e.g. a length or a checksum.
+     */
+    template<byte_sink Sink>
     class bitwriter {
     public:
+        static constexpr const bool word_writes = contiguous_byte_sink<Sink>;
+
+        //----------------------------------------------------------------------
+        struct reserved_field
+        {
+            size_t position;
+            size_t bits;
+        };
+
         //----------------------------------------------------------------------
         bitwriter(std::shared_ptr<Sink> sink)
         {
@@ -46,7 +70,9 @@ namespace brcpp {
         //----------------------------------------------------------------------
         void flush()
         {
-            if ((internal_state::buffer_size - _state.avail) % 8 != 0) {
+            if constexpr (word_writes) {
+                _state.flush();
+            } else if ((internal_state::buffer_size - _state.avail) % 8 != 0) {
                 _state.flush();
             }
             
@@ -56,25 +82,32 @@ namespace brcpp {
         template<bit_readable T>
         void write(T data, size_t bits)
         {
-            size_t written = 0;
-            size_t to_write = bits;
-
             using FT = fitting_integral<T>;
             const auto bit_data = std::bit_cast<FT>(data);
+            if (bits > sizeof(FT)*8) {
+                throw std::runtime_error("Invalid write size");
+            }
+
+            if constexpr (word_writes) {
+                _state.put(static_cast<uint64_t>(bit_data) & _mask<uint64_t>(bits), bits);
+            } else {
+                size_t written = 0;
+                size_t to_write = bits;
 
-            while (written < bits) {
-                size_t post = std::min<uint64_t>(_state.avail, to_write);
-                FT portion = (bit_data >> (bits - written - post)) & _mask<FT>(post);
-                size_t diff = _state.avail - post;
-                _state.buffer |= static_cast<internal_state::buffer_type>(portion << diff);
-                _state.avail -= post;
+                while (written < bits) {
+                    size_t post = std::min<uint64_t>(_state.avail, to_write);
+                    FT portion = (bit_data >> (bits - written - post)) & _mask<FT>(post);
+                    size_t diff = _state.avail - post;
+                    _state.buffer |= static_cast<internal_state::buffer_type>(portion << diff);
+                    _state.avail -= post;
 
-                if (_state.avail == 0) {
-                    _state.flush();
-                }
+                    if (_state.avail == 0) {
+                        _state.flush();
+                    }
 
-                written += post;
-                to_write -= post;
+                    written += post;
+                    to_write -= post;
+                }
             }
         }
 
@@ -94,7 +127,196 @@ namespace brcpp {
             T::write(*this, data);
         }
 
+        //----------------------------------------------------------------------
+        /**
+         * @brief Write each value as a field of the given width
+         */
+        template<bit_readable T>
+        void write_n(std::span<const T> values, size_t bits)
+        {
+            using FT = fitting_integral<T>;
+            if (bits > sizeof(FT)*8) {
+                throw std::runtime_error("Invalid write size");
+            }
+
+            if constexpr (word_writes) {
+                if (bits == sizeof(FT)*8 && _state.count % 8 == 0) {
+                    _write_whole(values);
+                    return;
+                }
+
+                if constexpr (sizeof(FT) <= sizeof(uint32_t)) {
+                    values = _write_packed(values, bits);
+                }
+
+                const auto mask = _mask<uint64_t>(bits);
+                for (const auto& value: values) {
+                    _state.put(static_cast<uint64_t>(std::bit_cast<FT>(value)) & mask, bits);
+                }
+            } else {
+                for (const auto& value: values) {
+                    write(value, bits);
+                }
+            }
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Write raw bytes, at any bit position
+         */
+        void write_bytes(std::span<const uint8_t> data)
+        {
+            if constexpr (word_writes) {
+                if (_state.count % 8 == 0) {
+                    _write_whole(data);
+                    return;
+                }
+
+                // Unaligned: a word in, a word out, the accumulator does the shifting
+                size_t done = 0;
+                for (; data.size() - done >= 8; done += 8) {
+                    _state.put(load_be64(data.data() + done), 64);
+                }
+                for (; done < data.size(); ++done) {
+                    _state.put(data[done], 8);
+                }
+            } else if (_state.avail == internal_state::buffer_size) {
+                for (auto byte: data) {
+                    _state.sink->put(byte, 8);
+                }
+            } else {
+                for (auto byte: data) {
+                    write(byte, 8);
+                }
+            }
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Write a zero field of the given width, to be patched later
+         */
+        reserved_field reserve(size_t bits) requires patchable_byte_sink<Sink>
+        {
+            if (bits > 64) {
+                throw std::runtime_error("Invalid write size");
+            }
+
+            reserved_field field{position(), bits};
+            skip(bits);
+            return field;
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Fill in a reserved field, wherever its bits are by now
+         */
+        template<bit_readable T>
+        void patch(const reserved_field& field, T data) requires patchable_byte_sink<Sink>
+        {
+            using FT = fitting_integral<T>;
+            const uint64_t value = static_cast<uint64_t>(std::bit_cast<FT>(data)) & _mask<uint64_t>(field.bits);
+            const size_t begin = field.position;
+            const size_t end = begin + field.bits;
+            const size_t written = _state.sink->position()*8;
+            if (field.bits == 0) {
+                return;
+            } else if (end > position()) {
+                throw std::range_error("Cannot patch beyond the output");
+            }
+
+            // The tail may still be in the accumulator
+            if (end > written) {
+                const size_t start = std::max(begin, written);
+                const size_t shift = state_type::buffer_size - (end - written);
+                const uint64_t mask = _mask<uint64_t>(end - start) << shift;
+                const uint64_t bits = (value & _mask<uint64_t>(end - start)) << shift;
+                using buffer_type = decltype(_state.buffer);
+                _state.buffer = static_cast<buffer_type>((static_cast<uint64_t>(_state.buffer) & ~mask) | bits);
+            }
+
+            // The rest has been handed over, merge it into the sink byte-wise
+            if (begin < written) {
+                const size_t last = std::min(end, written);
+                const size_t first = begin / 8;
+                const size_t count = (last + 7) / 8 - first;
+                uint8_t bytes[9] = {};
+                uint8_t mask[9] = {};
+                for (size_t iter = 0; iter < count; ++iter) {
+                    const size_t lo = std::max(begin, (first + iter)*8);
+                    const size_t hi = std::min(last, (first + iter + 1)*8);
+                    const size_t shift = (first + iter + 1)*8 - hi;
+                    const uint64_t portion = _mask<uint64_t>(hi - lo);
+                    mask[iter] = static_cast<uint8_t>(portion << shift);
+                    bytes[iter] = static_cast<uint8_t>(((value >> (end - hi)) & portion) << shift);
+                }
+
+                _state.sink->merge_at(first, bytes, mask, count);
+            }
+        }
+
     private:
+        // Bulk writes fill the sink window in chunks of at most this size
+        static constexpr const size_t BulkChunk = 64 * 1024;
+        // Packed fixed-width values go through a stack buffer of this many words
+        static constexpr const size_t PackChunk = 256;
+
+        //----------------------------------------------------------------------
+        template<bit_readable T>
+        void _write_whole(std::span<const T> values)
+        {
+            using FT = fitting_integral<T>;
+            constexpr size_t width = sizeof(FT);
+
+            // Byte aligned: hand the whole bytes over, then store big-endian
+            // values straight into the window
+            _state.flush();
+            size_t done = 0;
+            while (done < values.size()) {
+                const size_t chunk = std::min(values.size() - done, BulkChunk / width);
+                uint8_t* out = _state.sink->window(chunk * width);
+                if constexpr (width == 1) {
+                    std::memcpy(out, values.data() + done, chunk);
+                } else {
+                    for (size_t iter = 0; iter < chunk; ++iter) {
+                        const auto value = std::bit_cast<FT>(values[done + iter]);
+                        for (size_t byte = 0; byte < width; ++byte) {
+                            out[iter*width + byte] = static_cast<uint8_t>(value >> (8*(width - 1 - byte)));
+                        }
+                    }
+                }
+
+                _state.sink->commit(chunk * width);
+                done += chunk;
+            }
+        }
+
+        //----------------------------------------------------------------------
+        template<bit_readable T>
+        std::span<const T> _write_packed(std::span<const T> values, size_t bits)
+        {
+            constexpr size_t width = sizeof(fitting_integral<T>);
+            constexpr size_t per_word = sizeof(uint64_t) / width;
+            if (bits == 0) {
+                return values;
+            }
+
+            // Whole words of values packed at once, the rest is left over
+            uint64_t words[PackChunk];
+            auto data = reinterpret_cast<const uint8_t*>(values.data());
+            while (values.size() >= per_word) {
+                const size_t chunk = std::min(values.size(), PackChunk * per_word);
+                const size_t packed = pack_bits(data, chunk, width, bits, words);
+                for (size_t iter = 0; iter < packed; ++iter) {
+                    _state.put(words[iter], per_word * bits);
+                }
+
+                data += packed * sizeof(uint64_t);
+                values = values.subspan(packed * per_word);
+            }
+
+            return values;
+        }
+
         //----------------------------------------------------------------------
         struct internal_state
         {
@@ -116,6 +338,54 @@ namespace brcpp {
             }
         };
 
+        //----------------------------------------------------------------------
+        struct word_state
+        {
+            static constexpr const size_t buffer_size = 64;
+
+            std::shared_ptr<Sink> sink;
+            uint64_t buffer;    // MSB-aligned
+            size_t count;       // bits used
+
+            void reset() {
+                buffer = 0;
+                count = 0;
+            }
+
+            void put(uint64_t value, size_t bits) {
+                if (bits == 0) {
+                    return;
+                }
+
+                const size_t free = buffer_size - count;
+                if (bits < free) {
+                    buffer |= value << (free - bits);
+                    count += bits;
+                    return;
+                }
+
+                const size_t rest = bits - free;
+                buffer |= value >> rest;
+                store(sizeof(buffer));
+                buffer = rest > 0 ? value << (buffer_size - rest) : 0;
+                count = rest;
+            }
+
+            void store(size_t bytes) {
+                store_be64(sink->window(sizeof(buffer)), buffer);
+                sink->commit(bytes);
+            }
+
+            void flush() {
+                if (count > 0) {
+                    store((count + 7) / 8);
+                    this->reset();
+                }
+            }
+        };
+
+        using state_type = std::conditional_t<word_writes, word_state, internal_state>;
+
         //----------------------------------------------------------------------
         template<typename T>
         static constexpr T _mask(size_t bits)
@@ -138,15 +408,25 @@ namespace brcpp {
         }
 
         //----------------------------------------------------------------------
-        size_t _position(const internal_state& state) const
+        size_t _position(const state_type& state) const
         {
-            return state.sink->position()*8 + internal_state::buffer_size - state.avail;
+            if constexpr (word_writes) {
+                return state.sink->position()*8 + state.count;
+            } else {
+                return state.sink->position()*8 + internal_state::buffer_size - state.avail;
+            }
         }
 
         //----------------------------------------------------------------------
-        void _skip(internal_state& state, size_t bits) const
+        void _skip(state_type& state, size_t bits) const
         {
-            if (bits < state.avail) {
+            if constexpr (word_writes) {
+                while (bits > 0) {
+                    auto portion = std::min<size_t>(bits, word_state::buffer_size);
+                    state.put(0, portion);
+                    bits -= portion;
+                }
+            } else if (bits < state.avail) {
                 state.avail -= bits;
             } else if (bits == state.avail) {
                 state.avail = 0;
@@ -171,7 +451,7 @@ namespace brcpp {
         }
 
         //----------------------------------------------------------------------
-        void _align(internal_state& state, size_t bits) const
+        void _align(state_type& state, size_t bits) const
         {
             size_t advance = (bits - _position(state) % bits) % bits;
             if (advance > 0) {
@@ -179,6 +459,6 @@ namespace brcpp {
             }
         }
 
-        internal_state _state;
+        state_type _state;
     };
 }
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "bitreader/common/file_reader.hpp"
+#include "bitreader/common/shared_buffer.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief LRU cache of fixed-size file blocks keyed by (file, block index).
+     *
+     * Thread-safe, so a single cache can back any number of readers and their
+     * clones. Evicted blocks stay alive for as long as somebody holds them.
+     */
+    class block_cache
+    {
+    public:
+        static constexpr const size_t DefaultBlockSize = 64 * 1024;
+        static constexpr const size_t DefaultBudget = 64 * 1024 * 1024;
+
+        //----------------------------------------------------------------------
+        struct statistics
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            size_t memory = 0;
+        };
+
+        //----------------------------------------------------------------------
+        explicit block_cache(
+                size_t block_size = DefaultBlockSize,
+                size_t budget = DefaultBudget);
+
+        block_cache(const block_cache&) = delete;
+        block_cache& operator=(const block_cache&) = delete;
+
+        /**
+         * @brief Get a block, reading it through the reader on a miss
+         * @param file File identifier obtained from register_file()
+         * @param block Index of the block (position / block_size())
+         * @param reader Reader to load the block with
+         * @return Block contents, shorter than block_size() at the end of file
+         */
+        shared_buffer get(uint64_t file, uint64_t block, file_reader& reader);
+
+        /**
+         * @return A new identifier to key the blocks of one file with
+         */
+        uint64_t register_file();
+
+        void clear();
+        statistics stats() const;
+        size_t block_size() const { return _block_size; }
+        size_t budget() const { return _budget; }
+
+    private:
+        //----------------------------------------------------------------------
+        struct key
+        {
+            uint64_t file;
+            uint64_t block;
+
+            bool operator==(const key& other) const = default;
+        };
+
+        struct key_hash
+        {
+            size_t operator()(const key& k) const
+            {
+                auto h = k.file * 0x9E3779B97F4A7C15ull ^ k.block;
+                return static_cast<size_t>(h ^ (h >> 29));
+            }
+        };
+
+        struct entry
+        {
+            shared_buffer data;
+            std::list<key>::iterator lru;
+        };
+
+        void evict();
+
+        const size_t _block_size;
+        const size_t _budget;
+        std::atomic<uint64_t> _next_file{0};
+
+        mutable std::mutex _lock;
+        std::list<key> _lru;
+        std::unordered_map<key, entry, key_hash> _blocks;
+        statistics _stats;
+    };
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include "bitreader/common/shared_buffer.hpp"
+
+namespace brcpp
+{
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Thread-safe pool of aligned buffers.
+     *
+     * Buffers come in size classes: buffer_size() and its doublings, up to
+     * SizeClasses of them. Each thread keeps a few released buffers per
+     * class in a shard of the pool picked for it, so threads that keep
+     * acquiring and releasing do not contend on the shared free lists;
+     * those hold up to max_buffers per class and are only used when the
+     * shard is empty or full. Threads beyond the number of shards share
+     * them. Everything cached goes when the pool does.
+     *
+     * Sizes outside the classes are allocated directly and never pooled.
+     * The memory resource must outlive all buffers of the pool.
+     */
+    class buffer_pool
+    {
+    public:
+        static constexpr const size_t SizeClasses = 12;
+        static constexpr const size_t ThreadCacheSize = 2;
+        static constexpr const size_t CacheShards = 8;
+
+        //----------------------------------------------------------------------
+        struct statistics
+        {
+            uint64_t hits = 0;      // acquires served from the pool
+            uint64_t misses = 0;    // acquires that had to allocate
+            size_t in_use = 0;      // pooled-size buffers not released yet
+            size_t high_water = 0;  // the most buffers ever in use at once
+        };
+
+        //----------------------------------------------------------------------
+        buffer_pool(
+                size_t buffer_size,
+                size_t alignment,
+                size_t max_buffers,
+                std::pmr::memory_resource* resource = nullptr);
+
+        buffer_pool(const buffer_pool&) = delete;
+        buffer_pool& operator=(const buffer_pool&) = delete;
+
+        /**
+         * @return An empty buffer of buffer_size() capacity, reused if possible
+         */
+        shared_buffer acquire();
+
+        /**
+         * @return An empty buffer of the given capacity, reused if possible
+         */
+        shared_buffer acquire(size_t size);
+
+        /**
+         * @brief Return a buffer obtained from acquire() back to the pool.
+         *        The caller must not keep other references to it. Buffers
+         *        that did not come from this pool are ignored.
+         */
+        void release(shared_buffer buffer);
+
+        size_t buffer_size() const { return _buffer_size; }
+        size_t alignment() const { return _alignment; }
+        std::pmr::memory_resource* resource() const { return _resource; }
+
+        /**
+         * @return Whether buffers of this capacity are pooled
+         */
+        bool pooled(size_t size) const { return size_class(size) < SizeClasses; }
+
+        statistics stats() const;
+
+    private:
+        //----------------------------------------------------------------------
+        struct alignas(64) cache_shard
+        {
+            std::mutex lock;
+            shared_buffer slots[SizeClasses][ThreadCacheSize];
+            size_t count[SizeClasses] = {};
+        };
+
+        cache_shard& local_shard();
+        size_t size_class(size_t size) const;
+        void count_acquire();
+        shared_buffer allocate(size_t size) const;
+
+        const uint64_t _id;     // marks the buffers allocated by this pool
+        const size_t _buffer_size;
+        const size_t _alignment;
+        const size_t _max_buffers;
+        std::pmr::memory_resource* const _resource;
+
+        std::array<cache_shard, CacheShards> _shards;
+        std::mutex _lock;
+        std::array<std::vector<shared_buffer>, SizeClasses> _free;
+
+        std::atomic<uint64_t> _hits{0};
+        std::atomic<uint64_t> _misses{0};
+        std::atomic<size_t> _in_use{0};
+        std::atomic<size_t> _high_water{0};
+    };
+}
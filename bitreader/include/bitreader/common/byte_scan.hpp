@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace brcpp
+{
+    /**
+     * @brief Find the first occurrence of a byte pattern in [begin, end).
+     *
+     * Vectorized with SSE2 or NEON where available: candidates are picked
+     * by comparing the first and the last pattern byte 16 positions at a
+     * time, so runs without them are skipped at memory speed.
+     *
+     * @return Pointer to the start of the match, or end if there is none
+     */
+    const uint8_t* find_bytes(
+            const uint8_t* begin,
+            const uint8_t* end,
+            const uint8_t* pattern,
+            size_t size);
+
+    /**
+     * @brief Pack fixed-width values into 64-bit words, MSB first.
+     *
+     * Values are width (1, 2 or 4) bytes wide in native order, each word
+     * takes 8 / width of them cut to their low bits, the first on top,
+     * and keeps them right-aligned. Vectorized with SSE2 or NEON where
+     * available, by merging neighbouring values in ever wider lanes.
+     *
+     * @return Number of words written, only whole ones are packed
+     */
+    size_t pack_bits(
+            const uint8_t* values,
+            size_t count,
+            size_t width,
+            size_t bits,
+            uint64_t* words);
+}
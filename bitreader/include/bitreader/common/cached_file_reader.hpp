@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+#include "bitreader/common/block_cache.hpp"
+#include "bitreader/common/file_reader.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief File reader that serves reads from a shared block cache.
+     *
+     * Clones keep the file identity, so every byte source built on top of
+     * the reader or any of its clones shares the cached blocks. Byte
+     * sources that borrow() the blocks read them in place, so a block is
+     * held in memory once however many sources use it.
+     */
+    class cached_file_reader: public file_reader
+    {
+    public:
+        size_t read(uint8_t* dest, uint64_t position, size_t bytes) override;
+        uint64_t size() override;
+        bool depleted() override;
+        void prefetch(uint64_t position, size_t bytes) override;
+        shared_buffer borrow(uint64_t position, uint64_t& start) override;
+        ~cached_file_reader() override = default;
+        std::shared_ptr<file_reader> clone() override;
+        static std::shared_ptr<file_reader> wrap(
+                std::shared_ptr<file_reader> reader,
+                std::shared_ptr<block_cache> cache);
+
+    private:
+        cached_file_reader(
+                std::shared_ptr<file_reader> reader,
+                std::shared_ptr<block_cache> cache,
+                uint64_t file);
+
+        std::shared_ptr<file_reader> _reader;
+        std::shared_ptr<block_cache> _cache;
+        const uint64_t _file;
+    };
+}
@@ -17,6 +17,7 @@ namespace brcpp
         size_t read(uint8_t* dest, uint64_t position, size_t bytes) override;
         uint64_t size() override;
         bool depleted() override;
+        void prefetch(uint64_t position, size_t bytes) override;
         ~direct_file_reader() override;
         std::shared_ptr<file_reader> clone() override;
         static std::shared_ptr<file_reader> open(const std::string& path);
@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <memory>
 
+#include "bitreader/common/shared_buffer.hpp"
+
 namespace brcpp
 {
     class file_reader
@@ -12,6 +14,27 @@ namespace brcpp
         virtual uint64_t size() = 0;
         virtual bool depleted() = 0;
         virtual std::shared_ptr<file_reader> clone() = 0;
+
+        /**
+         * @return Alignment that read() requires for the destination pointer,
+         *         the position and the byte count (1 means no constraint)
+         */
+        virtual size_t alignment() { return 1; }
+
+        /**
+         * @brief Hint that the given range is going to be read soon.
+         *        Must not block; the default implementation does nothing.
+         */
+        virtual void prefetch(uint64_t position, size_t bytes) {}
+
+        /**
+         * @brief Lend data the reader already holds in memory around the
+         *        given position, to be used instead of a read() copy.
+         *        The default implementation holds none.
+         * @param start Set to the file position of the first lent byte
+         * @return The data, empty if there is none to lend
+         */
+        virtual shared_buffer borrow(uint64_t position, uint64_t& start) { return {}; }
         virtual ~file_reader() = default;
     };
 }
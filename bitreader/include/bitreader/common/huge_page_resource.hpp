@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+
+namespace brcpp
+{
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Memory resource that maps large allocations directly, backed
+     *        by huge pages where the system allows it (explicit huge pages
+     *        first, transparent ones otherwise), to cut TLB misses on
+     *        multi-megabyte windows. Smaller allocations, and all of them
+     *        on systems without the support, go to the upstream resource.
+     */
+    class huge_page_resource: public std::pmr::memory_resource
+    {
+    public:
+        static constexpr const size_t HugePageSize = 2 * 1024 * 1024;
+
+        explicit huge_page_resource(
+                size_t threshold = HugePageSize,
+                std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+        huge_page_resource(const huge_page_resource&) = delete;
+        huge_page_resource& operator=(const huge_page_resource&) = delete;
+
+        size_t threshold() const { return _threshold; }
+        std::pmr::memory_resource* upstream() const { return _upstream; }
+
+        /**
+         * @return Number of live allocations mapped by this resource
+         */
+        size_t mapped() const { return _mapped.load(std::memory_order_relaxed); }
+
+        /**
+         * @return Total size of the live mappings, in whole huge pages
+         */
+        size_t mapped_bytes() const { return _mapped_bytes.load(std::memory_order_relaxed); }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        bool is_mapped(size_t bytes, size_t alignment) const;
+
+        size_t _threshold;
+        std::pmr::memory_resource* _upstream;
+        std::atomic<size_t> _mapped{0};
+        std::atomic<size_t> _mapped_bytes{0};
+    };
+}
@@ -1,4 +1,7 @@
 #pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 namespace brcpp
@@ -13,4 +16,36 @@ constexpr const T one = T{1};
 template<arithmetic T>
 constexpr const T zero = T{0};
 
-}
\ No newline at end of file
+//------------------------------------------------------------------------------
+constexpr uint64_t byteswap64(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#else
+    value = ((value & 0x00FF00FF00FF00FFull) << 8) | ((value >> 8) & 0x00FF00FF00FF00FFull);
+    value = ((value & 0x0000FFFF0000FFFFull) << 16) | ((value >> 16) & 0x0000FFFF0000FFFFull);
+    return (value << 32) | (value >> 32);
+#endif
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t load_be64(const uint8_t* data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    if constexpr (std::endian::native == std::endian::little) {
+        value = byteswap64(value);
+    }
+    return value;
+}
+
+//------------------------------------------------------------------------------
+inline void store_be64(uint8_t* data, uint64_t value)
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        value = byteswap64(value);
+    }
+    std::memcpy(data, &value, sizeof(value));
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include <string>
+#include <memory>
+
+#include "bitreader/common/buffer_pool.hpp"
+#include "bitreader/common/file_reader.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief File reader that bypasses the page cache (O_DIRECT).
+     *
+     * Reads that already satisfy the alignment constraints go straight into
+     * the destination buffer, everything else is bounced through aligned
+     * buffers taken from a pool shared between the reader and its clones.
+     */
+    class odirect_file_reader: public file_reader
+    {
+    public:
+        static constexpr const size_t DefaultAlignment = 4096;
+
+        size_t read(uint8_t* dest, uint64_t position, size_t bytes) override;
+        uint64_t size() override;
+        bool depleted() override;
+        size_t alignment() override;
+        ~odirect_file_reader() override;
+        std::shared_ptr<file_reader> clone() override;
+        static std::shared_ptr<file_reader> open(
+                const std::string& path,
+                size_t alignment = DefaultAlignment);
+
+    private:
+        odirect_file_reader(
+                const std::string& path,
+                size_t alignment,
+                std::shared_ptr<buffer_pool> pool);
+
+        size_t read_aligned(uint8_t* dest, uint64_t position, size_t bytes);
+
+        const std::string _path;
+        const size_t _alignment;
+        std::shared_ptr<buffer_pool> _pool;
+        int _fd;
+    };
+}
@@ -2,31 +2,79 @@
 #include <cstdint>
 #include <cstddef>
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <memory_resource>
 
 namespace brcpp
 {
     //--------------------------------------------------------------------------
+    /**
+     * @brief Reference-counted byte buffer. Copies share the data (and the
+     *        size); the reference count lives in a header placed in the
+     *        same allocation as the data, so a buffer costs one allocation.
+     *        With a memory resource other than the default one the header
+     *        is allocated separately, so the resource is asked for exactly
+     *        the capacity (e.g. whole huge pages).
+     *
+     * slice() gives a fixed-size view of a sub-range that keeps the whole
+     * buffer alive, without copying.
+     *
+     * Memory comes from a std::pmr::memory_resource, the default one
+     * (std::pmr::get_default_resource()) unless specified; buffers derived
+     * by clone(), realloc() and resize() stay with the same resource and
+     * alignment, also when they grow again after being emptied by take(),
+     * realloc(0) or a move.
+     *
+     * Growing past the capacity with resize() allocates growth_factor()
+     * times the current capacity (or the new size, if more), so appending
+     * byte by byte costs amortized constant time.
+     */
     class shared_buffer
     {
+        struct _header;
+
     public:
+        static constexpr const double DefaultGrowthFactor = 2.0;
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Frees storage handed out by take()
+         */
+        class storage_deleter
+        {
+        public:
+            storage_deleter() = default;
+            void operator()(uint8_t*) const;
+
+        private:
+            friend class shared_buffer;
+            explicit storage_deleter(_header* state): _state(state) {}
+            _header* _state = nullptr;
+        };
+
+        using storage = std::unique_ptr<uint8_t[], storage_deleter>;
+
         //----------------------------------------------------------------------
         shared_buffer();
 
         //----------------------------------------------------------------------
-        shared_buffer(shared_buffer&& other) = default;
-        shared_buffer(const shared_buffer& other) = default;
-        shared_buffer& operator=(const shared_buffer& other) = default;
-        ~shared_buffer() = default;
+        shared_buffer(shared_buffer&& other) noexcept;
+        shared_buffer(const shared_buffer& other);
+        shared_buffer& operator=(shared_buffer&& other) noexcept;
+        shared_buffer& operator=(const shared_buffer& other);
+        ~shared_buffer();
 
         //----------------------------------------------------------------------
         using iterator = uint8_t*;
         using const_iterator = const uint8_t*;
 
-        size_t size() const { return _state->size; }
-        size_t capacity() const { return _state->capacity; }
-        const uint8_t* get() const { return _state->data; }
-        uint8_t* get() { return _state->data; }
+        size_t size() const { return _slice ? _length : _state->size; }
+        size_t capacity() const { return _slice ? _length : _state->capacity; }
+        size_t alignment() const;
+        std::pmr::memory_resource* resource() const { return _resource; }
+        const uint8_t* get() const { return _state->data + _offset; }
+        uint8_t* get() { return _state->data + _offset; }
 
         iterator begin() { return get(); }
         iterator end() { return get() + size(); }
@@ -37,34 +85,94 @@ namespace brcpp
 
         //----------------------------------------------------------------------
         static shared_buffer wrap_mem(uint8_t* data, size_t size);
-        static shared_buffer copy_mem(const uint8_t* data, size_t size);
+        static shared_buffer copy_mem(
+                const uint8_t* data,
+                size_t size,
+                std::pmr::memory_resource* resource = nullptr);
         static shared_buffer clone(const shared_buffer& buffer);
         static shared_buffer allocate(size_t size);
+        static shared_buffer allocate(
+                size_t size,
+                size_t alignment,
+                std::pmr::memory_resource* resource = nullptr);
         void realloc(size_t new_size);
         void resize(size_t new_size);
+
+        /**
+         * @brief Make sure the capacity is at least the given one,
+         *        keeping the size and the data
+         */
+        void reserve(size_t capacity);
+
+        /**
+         * @brief Hand the data over to the caller without copying it and
+         *        leave this buffer empty. Read size() first if needed.
+         *        Fails if the data is shared with other buffers.
+         */
+        storage take();
+
+        double growth_factor() const { return _growth; }
+        void set_growth_factor(double factor);
+
         operator bool() const;
         uint8_t operator[](size_t index) const { return get()[index]; }
 
+        /**
+         * @brief View of [offset, offset + length) of this buffer's data
+         *        sharing its ownership. The view has a fixed size; growing
+         *        it with resize() or realloc() detaches it into a copy.
+         */
+        shared_buffer slice(size_t offset, size_t length) const;
+
+        /**
+         * @return Whether this buffer is a view created by slice()
+         */
+        bool is_slice() const { return _slice; }
+
+        /**
+         * @return Number of buffers sharing this one's data (0 if empty)
+         */
+        size_t use_count() const;
+
     private:
+        friend class buffer_pool;
+
         //----------------------------------------------------------------------
-        struct _internal
+        struct _header
         {
+            std::atomic<size_t> refs{1};
             uint8_t* data = nullptr;
             size_t capacity = 0;
             size_t size = 0;
+            size_t alignment = 0;   // 0 means default operator new[] alignment
+            size_t block_alignment = 0; // of the allocation holding the header
+            size_t block_size = 0;
+            std::pmr::memory_resource* resource = nullptr; // null if external
+            bool external = false;  // data allocated separately with new[]
+            bool separate = false;  // data alone in its block from resource
+            uint64_t pool = 0;      // id of the buffer_pool owning it, 0 if none
         };
 
-        //----------------------------------------------------------------------
-        static std::shared_ptr<_internal> make_internal(_internal state);
-        static std::shared_ptr<_internal> make_internal(
-                uint8_t* data,
-                size_t size,
-                size_t capacity);
+        static _header* make_header(
+                size_t capacity,
+                size_t alignment,
+                std::pmr::memory_resource* resource);
+        static _header* wrap_header(uint8_t* data, size_t size);
+        static _header* empty_header();
+        static void release(_header* state);
 
-        explicit shared_buffer(_internal state);
-        explicit shared_buffer(std::shared_ptr<_internal> state);
+        explicit shared_buffer(_header* state);
+        void acquire() const;
+        void grow(size_t capacity, size_t new_size);
 
-        std::shared_ptr<_internal> _state;
+        _header* _state;
+        size_t _offset = 0;
+        size_t _length = 0;
+        bool _slice = false;
+        double _growth = DefaultGrowthFactor;
+        // Of the data, remembered for growing again once emptied
+        std::pmr::memory_resource* _resource = nullptr;
+        size_t _alignment = 0;
     };
 
     //--------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <concepts>
+
+namespace brcpp
+{
+
+template<typename T>
+concept byte_sink = requires(T s, uint8_t data, size_t bits)
+{
+    { s.put(data, bits) };
+    { s.position() } -> std::convertible_to<size_t>;
+};
+
+/**
+ * @brief Sinks that let the writer store into their memory directly.
+ *        window(bytes) returns room for at least that many bytes at
+ *        position(); commit(bytes) makes the first ones part of the output.
+ *        Bytes stored past the committed ones are scratch.
+ */
+template<typename T>
+concept contiguous_byte_sink = byte_sink<T> && requires(T s, size_t bytes)
+{
+    { s.window(bytes) } -> std::same_as<uint8_t*>;
+    { s.commit(bytes) } -> std::same_as<void>;
+};
+
+/**
+ * @brief Sinks that can change output written earlier. merge_at()
+ *        replaces the bits selected by mask in [position, position + size).
+ */
+template<typename T>
+concept patchable_byte_sink = byte_sink<T> &&
+    requires(T s, uint64_t position, const uint8_t* data, size_t size)
+{
+    { s.merge_at(position, data, data, size) } -> std::same_as<void>;
+};
+
+//------------------------------------------------------------------------------
+inline void merge_bytes(uint8_t* dest, const uint8_t* data, const uint8_t* mask, size_t size)
+{
+    for (size_t iter = 0; iter < size; ++iter) {
+        dest[iter] = static_cast<uint8_t>((dest[iter] & ~mask[iter]) | (data[iter] & mask[iter]));
+    }
+}
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "bitreader/common/buffer_pool.hpp"
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_sink/byte_sink.hpp"
+
+namespace brcpp
+{
+    //--------------------------------------------------------------------------
+    enum class sync_policy
+    {
+        none,           // leave it to the OS
+        on_close,       // fsync once the file is complete
+        every_block     // fdatasync after each block, fsync on close
+    };
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Output file written behind the encoder.
+     *
+     * The output is collected in large aligned blocks; full blocks are
+     * queued to a background thread that writes them with pwrite() while
+     * encoding goes on. At most queue_depth blocks wait at a time, after
+     * that the encoder waits for the disk. Write errors are reported by the
+     * next call that hands over a block, or by close().
+     */
+    class file_sink
+    {
+    public:
+        static constexpr const size_t DefaultBlockSize = 1024 * 1024;
+        static constexpr const size_t DefaultQueueDepth = 4;
+        static constexpr const size_t BlockAlignment = 4096;
+
+        explicit file_sink(
+                const std::string& path,
+                sync_policy sync = sync_policy::none,
+                size_t block_size = DefaultBlockSize,
+                size_t queue_depth = DefaultQueueDepth);
+
+        file_sink(const file_sink&) = delete;
+        file_sink& operator=(const file_sink&) = delete;
+
+        /**
+         * @brief Closes the file; errors are lost, call close() to see them
+         */
+        ~file_sink();
+
+        //----------------------------------------------------------------------
+        void put(uint8_t data, size_t)
+        {
+            *window(1) = data;
+            commit(1);
+        }
+
+        size_t position() const { return static_cast<size_t>(_block_offset + _block.size()); }
+
+        /**
+         * @return Room for at least the given number of bytes at position()
+         */
+        uint8_t* window(size_t bytes)
+        {
+            if (_block.capacity() - _block.size() < bytes) {
+                next_block(bytes);
+            }
+            return _block.get() + _block.size();
+        }
+
+        /**
+         * @brief Append the first bytes of the window to the output
+         */
+        void commit(size_t bytes)
+        {
+            if (_block.capacity() - _block.size() < bytes) {
+                throw std::range_error("Cannot commit beyond the window");
+            }
+
+            _block.resize(_block.size() + bytes);
+            if (_block.size() >= _block_size) {
+                submit_block();
+            }
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Overwrite output written earlier, e.g. to fill in a length
+         *        field; done in order with the queued blocks
+         */
+        void write_at(uint64_t position, const uint8_t* data, size_t size);
+
+        /**
+         * @brief Replace the bits selected by mask in output written
+         *        earlier; bytes already handed over are read back and
+         *        merged by the background thread
+         */
+        void merge_at(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size);
+
+        /**
+         * @brief Queue the partial block without waiting for it
+         */
+        void flush();
+
+        /**
+         * @brief Wait until everything is written and make it durable
+         */
+        void sync();
+
+        /**
+         * @brief Write everything out (and sync, if the policy says so)
+         *        and close the file
+         */
+        void close();
+
+    private:
+        struct job
+        {
+            uint64_t offset;
+            shared_buffer data;
+            shared_buffer mask; // empty for plain writes
+        };
+
+        void patch(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size);
+        static int merge_all(int fd, job& item);
+        void next_block(size_t bytes);
+        void submit_block();
+        void submit(job&& item);
+        void drain();
+        void check_error();
+        void writer();
+
+        const size_t _block_size;
+        const size_t _queue_depth;
+        const sync_policy _sync;
+        int _fd;
+
+        std::shared_ptr<buffer_pool> _pool;
+        shared_buffer _block;
+        uint64_t _block_offset = 0;
+
+        std::mutex _lock;
+        std::deque<job> _queue;
+        std::counting_semaphore<> _slots;
+        std::counting_semaphore<> _items{0};
+        std::atomic<size_t> _pending{0};
+        std::atomic<int> _error{0};
+        std::thread _thread;
+    };
+}
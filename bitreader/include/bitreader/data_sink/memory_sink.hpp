@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_sink/byte_sink.hpp"
+
+namespace brcpp
+{
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Growable in-memory sink. The output is kept in a shared_buffer
+     *        that grows geometrically and is handed over by finish()
+     *        without copying.
+     */
+    class memory_sink
+    {
+    public:
+        static constexpr const size_t DefaultCapacity = 4 * 1024;
+        static constexpr const size_t BufferAlignment = 64;
+
+        explicit memory_sink(
+                size_t capacity = DefaultCapacity,
+                std::pmr::memory_resource* resource = nullptr);
+
+        memory_sink(const memory_sink&) = delete;
+        memory_sink& operator=(const memory_sink&) = delete;
+
+        //----------------------------------------------------------------------
+        void put(uint8_t data, size_t)
+        {
+            *window(1) = data;
+            _buffer.resize(_buffer.size() + 1);
+        }
+
+        size_t position() const { return _buffer.size(); }
+
+        /**
+         * @return Room for at least the given number of bytes at position()
+         */
+        uint8_t* window(size_t bytes)
+        {
+            if (_buffer.capacity() - _buffer.size() < bytes) {
+                grow(bytes);
+            }
+            return _buffer.get() + _buffer.size();
+        }
+
+        /**
+         * @brief Append the first bytes of the window to the output
+         */
+        void commit(size_t bytes)
+        {
+            if (_buffer.capacity() - _buffer.size() < bytes) {
+                throw std::range_error("Cannot commit beyond the window");
+            }
+            _buffer.resize(_buffer.size() + bytes);
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Overwrite output written earlier, e.g. to fill in a length field
+         */
+        void write_at(uint64_t position, const uint8_t* data, size_t size);
+
+        /**
+         * @brief Replace the bits selected by mask in output written earlier
+         */
+        void merge_at(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size);
+
+        /**
+         * @brief Make room for the given total size up front
+         */
+        void reserve(size_t capacity);
+
+        const uint8_t* data() const { return _buffer.get(); }
+        size_t capacity() const { return _buffer.capacity(); }
+
+        /**
+         * @return The output written so far, without copying it. The sink
+         *         starts over empty afterwards.
+         */
+        shared_buffer finish();
+
+    private:
+        void grow(size_t bytes);
+
+        size_t _initial;
+        std::pmr::memory_resource* _resource;
+        shared_buffer _buffer;
+    };
+}
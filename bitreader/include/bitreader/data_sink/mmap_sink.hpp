@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include "bitreader/data_sink/byte_sink.hpp"
+
+namespace brcpp
+{
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Output file written directly through a shared memory mapping.
+     *
+     * The file is extended ahead of the output and the mapping grows along
+     * with it, geometrically; close() cuts the file down to the size
+     * actually written. Passing the expected size as the capacity up front
+     * avoids any remapping.
+     */
+    class mmap_sink
+    {
+    public:
+        static constexpr const size_t DefaultCapacity = 1024 * 1024;
+
+        explicit mmap_sink(const std::string& path, size_t capacity = DefaultCapacity);
+
+        mmap_sink(const mmap_sink&) = delete;
+        mmap_sink& operator=(const mmap_sink&) = delete;
+
+        /**
+         * @brief Closes the file; errors are lost, call close() to see them
+         */
+        ~mmap_sink();
+
+        //----------------------------------------------------------------------
+        void put(uint8_t data, size_t)
+        {
+            *window(1) = data;
+            ++_size;
+        }
+
+        size_t position() const { return _size; }
+
+        /**
+         * @return Room for at least the given number of bytes at position()
+         */
+        uint8_t* window(size_t bytes)
+        {
+            if (_capacity - _size < bytes) {
+                grow(bytes);
+            }
+            return _data + _size;
+        }
+
+        /**
+         * @brief Append the first bytes of the window to the output
+         */
+        void commit(size_t bytes)
+        {
+            if (_capacity - _size < bytes) {
+                throw std::range_error("Cannot commit beyond the window");
+            }
+            _size += bytes;
+        }
+
+        //----------------------------------------------------------------------
+        /**
+         * @brief Overwrite output written earlier, e.g. to fill in a length field
+         */
+        void write_at(uint64_t position, const uint8_t* data, size_t size);
+
+        /**
+         * @brief Replace the bits selected by mask in output written earlier
+         */
+        void merge_at(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size);
+
+        /**
+         * @brief Extend the file and the mapping to the given size up front
+         */
+        void reserve(size_t capacity);
+
+        const uint8_t* data() const { return _data; }
+        size_t capacity() const { return _capacity; }
+
+        /**
+         * @brief Write the mapped pages back to the file and wait for it
+         */
+        void sync();
+
+        /**
+         * @brief Cut the file to the written size, unmap and close it
+         */
+        void close();
+
+    private:
+        void grow(size_t bytes);
+        void remap(size_t capacity);
+
+        int _fd = -1;
+        uint8_t* _data = nullptr;
+        size_t _size = 0;
+        size_t _capacity = 0;
+        size_t _page_size;
+    };
+}
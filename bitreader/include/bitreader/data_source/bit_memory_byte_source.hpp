@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_source/memory_byte_source.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief Byte source over a bit range of a memory block that need not
+     *        start or end on a byte boundary, e.g. a sub-stream of a
+     *        bit-packed multiplex. Byte N of the source is made of bits
+     *        [offset + 8N, offset + 8N + 8) of the data; the shift is
+     *        applied while loading, so nothing is copied.
+     *
+     * bitreader honours bit_size(), so the padding bits of the last byte
+     * cannot be read.
+     */
+    class bit_memory_byte_source
+    {
+    public:
+        static constexpr const bool random_access = true;
+
+        bit_memory_byte_source();
+
+        /**
+         * @brief Read from a private copy of the bytes covering the range
+         */
+        bit_memory_byte_source(const uint8_t* data, uint64_t bit_offset, uint64_t bit_size);
+
+        /**
+         * @brief Read from caller-owned memory without copying it.
+         *        The memory must outlive the source and all its clones.
+         */
+        bit_memory_byte_source(
+                borrow_memory_t,
+                const uint8_t* data,
+                uint64_t bit_offset,
+                uint64_t bit_size);
+
+        /**
+         * @brief Read from the buffer without copying, sharing its ownership
+         */
+        bit_memory_byte_source(shared_buffer data, uint64_t bit_offset, uint64_t bit_size);
+
+        bit_memory_byte_source(const bit_memory_byte_source&) = default;
+        bit_memory_byte_source& operator=(const bit_memory_byte_source&) = default;
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<bit_memory_byte_source> clone();
+
+        /**
+         * @return Length of the range in bits
+         */
+        uint64_t bit_size() const
+        {
+            return _bit_size;
+        }
+
+    private:
+        uint8_t byte_at(uint64_t position) const;
+
+        shared_buffer _data;
+        const uint8_t* _begin;  // byte holding the first bit of the range
+        const uint8_t* _end;    // right past the byte holding the last bit
+        unsigned _shift;        // offset of the first bit within *_begin
+        uint64_t _bit_size;
+        uint64_t _size;         // bytes in the range, the last may be partial
+        uint64_t _position;
+    };
+}
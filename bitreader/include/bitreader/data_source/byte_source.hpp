@@ -3,10 +3,22 @@
 #include <cstddef>
 #include <concepts>
 #include <memory>
+#include <stdexcept>
 
 namespace brcpp
 {
 
+/**
+ * @brief Thrown when a source is temporarily out of data, but is not
+ *        depleted yet, i.e. more data may still arrive later.
+ *        Retrying the failed operation after that is safe.
+ */
+class need_more_data: public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
 template<typename T>
 concept byte_source = requires(T r, uint64_t& buf, uint64_t pos, size_t count)
 {
@@ -19,4 +31,43 @@ concept byte_source = requires(T r, uint64_t& buf, uint64_t pos, size_t count)
     { r.clone() } -> std::same_as<std::shared_ptr<T>>;
 };
 
+/**
+ * @brief Sources that produce their data on the fly (e.g. decompressors)
+ *        cannot tell how much is left. They declare
+ *        `static constexpr const bool available_is_lower_bound = true;`
+ *        and available() then only reports what is ready right away,
+ *        while skip() and seek() may go past it.
+ */
+template<typename T>
+concept lazy_byte_source = byte_source<T> && T::available_is_lower_bound;
+
+/**
+ * @brief Sources that keep all their data and seek anywhere cheaply
+ *        declare `static constexpr const bool random_access = true;`,
+ *        so that several readers can take turns on one of them.
+ */
+template<typename T>
+concept random_access_byte_source = byte_source<T> && T::random_access;
+
+/**
+ * @brief Sources backed by a single memory block, which can be scanned
+ *        in place. data() points to the byte at position 0.
+ */
+template<typename T>
+concept contiguous_byte_source = byte_source<T> && requires(const T r)
+{
+    { r.data() } -> std::same_as<const uint8_t*>;
+    { r.size() } -> std::same_as<uint64_t>;
+};
+
+/**
+ * @brief Sources whose data does not end on a byte boundary. The last
+ *        byte is padded, bit_size() tells where the data really ends.
+ */
+template<typename T>
+concept bit_sized_byte_source = byte_source<T> && requires(const T r)
+{
+    { r.bit_size() } -> std::same_as<uint64_t>;
+};
+
 }
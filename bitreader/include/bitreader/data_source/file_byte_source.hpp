@@ -2,15 +2,71 @@
 #include <cstdint>
 #include <cstddef>
 #include <memory>
+#include <memory_resource>
+#include "bitreader/common/buffer_pool.hpp"
 #include "bitreader/common/file_reader.hpp"
 #include "bitreader/common/shared_buffer.hpp"
 
 namespace brcpp
 {
+    //--------------------------------------------------------------------------
+    enum class access_pattern
+    {
+        sequential, // window misses continue where the previous window ended
+        strided,    // window misses are a constant distance apart
+        random      // anything else
+    };
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Byte source reading a file through an adaptive window.
+     *
+     * Windows are taken from a buffer_pool and returned to it when they are
+     * replaced or the source goes away. Clones share the window of their
+     * original until one of them has to refill it. Data the reader already
+     * holds in memory (see file_reader::borrow()) is used as the window
+     * directly, without a copy. The window left by a jump is kept aside,
+     * so that readers taking turns on the source (see
+     * bitreader::subreader()) do not reload it on every switch.
+     */
     class file_byte_source
     {
     public:
+        static constexpr const bool random_access = true;
+        static constexpr const size_t MinWindowSize = 4 * 1024;
+        static constexpr const size_t MaxWindowSize = 2 * 1024 * 1024;   // one huge page
+        static constexpr const size_t WindowAlignment = 64;
+        static constexpr const size_t PoolAlignment = 4096;
+        static constexpr const size_t MaxPooledWindows = 8;
+
         explicit file_byte_source(std::shared_ptr<file_reader> reader);
+
+        /**
+         * @param resource Where the windows are allocated, e.g. a
+         *        huge_page_resource; nullptr takes them from window_pool()
+         */
+        file_byte_source(
+                std::shared_ptr<file_reader> reader,
+                size_t min_window,
+                size_t max_window,
+                std::pmr::memory_resource* resource = nullptr);
+
+        /**
+         * @param pool Where the windows are taken from
+         */
+        file_byte_source(
+                std::shared_ptr<file_reader> reader,
+                size_t min_window,
+                size_t max_window,
+                std::shared_ptr<buffer_pool> pool);
+
+        ~file_byte_source();
+
+        /**
+         * @return The pool shared by all file sources by default
+         */
+        static std::shared_ptr<buffer_pool> window_pool();
+
         size_t get_n(uint64_t& buf, size_t bytes);
         bool depleted();
         uint64_t available();
@@ -19,12 +75,47 @@ namespace brcpp
         void skip(uint64_t bytes);
         std::shared_ptr<file_byte_source> clone();
 
+        access_pattern pattern() const { return _pattern; }
+        size_t window_size() const { return _buffer.capacity(); }
+
     private:
-        void load_buffer();
+        file_byte_source(
+                std::shared_ptr<file_reader> reader,
+                size_t min_window,
+                size_t max_window,
+                std::pmr::memory_resource* resource,
+                std::shared_ptr<buffer_pool> pool);
+
+        /**
+         * @brief Clone with the given reader, sharing the window
+         */
+        file_byte_source(const file_byte_source& other, std::shared_ptr<file_reader> reader);
+
+        void load_buffer(size_t bytes);
+        void adapt_window();
+        size_t round_window(size_t size) const;
+        shared_buffer allocate_window(size_t size) const;
+        void release_window();
+        void release_previous();
 
         std::shared_ptr<file_reader> _reader;
+        size_t _alignment;
+        size_t _min_window;
+        size_t _max_window;
+        std::pmr::memory_resource* _resource;
+        std::shared_ptr<buffer_pool> _pool;
         shared_buffer _buffer;
         uint64_t _position;
         uint64_t _last;
+        bool _borrowed = false;     // the window is the reader's, not ours
+
+        // The window before the last jump
+        shared_buffer _previous;
+        uint64_t _previous_last = 0;
+        bool _previous_borrowed = false;
+
+        access_pattern _pattern = access_pattern::sequential;
+        uint64_t _previous_miss = 0;
+        int64_t _stride = 0;
     };
 }
@@ -0,0 +1,752 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bitreader/lsb_bitreader.hpp"
+#include "bitreader/data_source/byte_source.hpp"
+
+namespace brcpp
+{
+    namespace detail
+    {
+        //----------------------------------------------------------------------
+        /**
+         * @brief Canonical Huffman decoding table for DEFLATE: codes up to
+         *        FastBits long are resolved with a single lookup, longer ones
+         *        are walked length by length.
+         */
+        struct inflate_table
+        {
+            static constexpr const size_t FastBits = 9;
+            static constexpr const size_t MaxBits = 15;
+
+            // Fast entries: symbol << 4 | code length, 0 means "not fast"
+            std::array<uint16_t, size_t(1) << FastBits> fast{};
+            std::array<uint16_t, MaxBits + 1> count{};
+            std::array<uint16_t, 320> symbols{};
+
+            //------------------------------------------------------------------
+            void build(const uint8_t* lengths, size_t n)
+            {
+                fast.fill(0);
+                count.fill(0);
+                for (size_t sym = 0; sym < n; ++sym) {
+                    ++count[lengths[sym]];
+                }
+                count[0] = 0;
+
+                int left = 1;
+                for (size_t len = 1; len <= MaxBits; ++len) {
+                    left = (left << 1) - count[len];
+                    if (left < 0) {
+                        throw std::runtime_error("Invalid deflate data: oversubscribed code");
+                    }
+                }
+
+                std::array<uint16_t, MaxBits + 2> offsets{};
+                std::array<uint16_t, MaxBits + 1> next_code{};
+                uint16_t code = 0;
+                for (size_t len = 1; len <= MaxBits; ++len) {
+                    offsets[len + 1] = static_cast<uint16_t>(offsets[len] + count[len]);
+                    code = static_cast<uint16_t>((code + count[len - 1]) << 1);
+                    next_code[len] = code;
+                }
+
+                for (size_t sym = 0; sym < n; ++sym) {
+                    const size_t len = lengths[sym];
+                    if (len == 0) {
+                        continue;
+                    }
+
+                    symbols[offsets[len]++] = static_cast<uint16_t>(sym);
+                    const auto canonical = next_code[len]++;
+                    if (len > FastBits) {
+                        continue;
+                    }
+
+                    // Codes are stored MSB-first in an LSB-first stream
+                    size_t reversed = 0;
+                    for (size_t bit = 0; bit < len; ++bit) {
+                        reversed |= size_t((canonical >> bit) & 1) << (len - 1 - bit);
+                    }
+
+                    const auto entry = static_cast<uint16_t>((sym << 4) | len);
+                    for (size_t k = reversed; k < fast.size(); k += size_t(1) << len) {
+                        fast[k] = entry;
+                    }
+                }
+            }
+        };
+
+        //----------------------------------------------------------------------
+        struct inflate_checksum
+        {
+            static constexpr std::array<uint32_t, 256> make_crc_table()
+            {
+                std::array<uint32_t, 256> table{};
+                for (uint32_t n = 0; n < 256; ++n) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; ++k) {
+                        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    }
+                    table[n] = c;
+                }
+                return table;
+            }
+
+            static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size)
+            {
+                static constexpr auto table = make_crc_table();
+                crc = ~crc;
+                for (size_t iter = 0; iter < size; ++iter) {
+                    crc = table[(crc ^ data[iter]) & 0xFF] ^ (crc >> 8);
+                }
+                return ~crc;
+            }
+
+            static uint32_t adler32(uint32_t adler, const uint8_t* data, size_t size)
+            {
+                constexpr uint32_t Base = 65521;
+                uint32_t a = adler & 0xFFFF;
+                uint32_t b = adler >> 16;
+                while (size > 0) {
+                    // 5552 is the largest run that cannot overflow b
+                    auto run = std::min<size_t>(size, 5552);
+                    size -= run;
+                    while (run-- > 0) {
+                        a += *data++;
+                        b += a;
+                    }
+                    a %= Base;
+                    b %= Base;
+                }
+                return (b << 16) | a;
+            }
+        };
+    }
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Byte source that inflates a DEFLATE, zlib or gzip stream read
+     *        from another byte source.
+     *
+     * The output is decoded on demand into a sliding window that doubles as
+     * the LZ77 history. Seeking forward decodes and discards, seeking back
+     * beyond the window restarts decoding from the beginning. The amount of
+     * data left is unknown until the end, so available() only reports what
+     * has been decoded so far (see lazy_byte_source).
+     */
+    template<byte_source Source>
+    class inflate_byte_source
+    {
+    public:
+        enum class format
+        {
+            automatic,  // detect gzip/zlib headers, raw DEFLATE otherwise
+            raw,
+            zlib,
+            gzip
+        };
+
+        static constexpr const bool available_is_lower_bound = true;
+        static constexpr const size_t HistorySize = 32 * 1024;
+        static constexpr const size_t OutputChunk = 64 * 1024;
+
+        //----------------------------------------------------------------------
+        explicit inflate_byte_source(
+                std::shared_ptr<Source> source,
+                format fmt = format::automatic)
+            : _origin(source->position())
+            , _in(std::move(source))
+            , _format(fmt)
+            , _out(HistorySize + OutputChunk + MaxMatch)
+        {
+        }
+
+        //----------------------------------------------------------------------
+        size_t get_n(uint64_t& buf, size_t bytes)
+        {
+            if (bytes == 0) {
+                return 0;
+            }
+
+            _produce(_cursor + bytes);
+            auto ready = _end() - _cursor;
+            if (ready == 0) {
+                throw std::runtime_error("Cannot read beyond the end of the inflated stream");
+            }
+
+            auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, ready));
+            const uint8_t* current = _out.data() + (_cursor - _out_start);
+            for (size_t iter = 0; iter < to_shift; ++iter) {
+                buf = (buf << 8) | current[iter];
+            }
+
+            _cursor += to_shift;
+            return to_shift;
+        }
+
+        //----------------------------------------------------------------------
+        bool depleted()
+        {
+            // The compressed input is expected to be complete
+            return true;
+        }
+
+        //----------------------------------------------------------------------
+        uint64_t available()
+        {
+            _produce(_cursor + Lookahead);
+            return _end() - _cursor;
+        }
+
+        //----------------------------------------------------------------------
+        uint64_t position()
+        {
+            return _cursor;
+        }
+
+        //----------------------------------------------------------------------
+        void seek(uint64_t position)
+        {
+            const auto previous = _cursor;
+            _advance(position);
+            if (position > _end()) {
+                // Leave the cursor where it was, decoding again if needed
+                _advance(previous);
+                _cursor = previous;
+                throw std::range_error("Cannot seek beyond the end of the inflated stream");
+            }
+
+            _cursor = position;
+        }
+
+        //----------------------------------------------------------------------
+        void skip(uint64_t bytes)
+        {
+            seek(_cursor + bytes);
+        }
+
+        //----------------------------------------------------------------------
+        std::shared_ptr<inflate_byte_source> clone()
+        {
+            return std::shared_ptr<inflate_byte_source>(new inflate_byte_source(*this));
+        }
+
+        /**
+         * @return Whether the whole stream (including trailers) has been decoded
+         */
+        bool finished() const
+        {
+            return _stage == stage::done;
+        }
+
+    private:
+        //----------------------------------------------------------------------
+        enum class stage
+        {
+            header,
+            block,
+            stored,
+            huffman,
+            trailer,
+            done
+        };
+
+        static constexpr const size_t MaxMatch = 258;
+        static constexpr const size_t Lookahead = 16;
+
+        //----------------------------------------------------------------------
+        inflate_byte_source(const inflate_byte_source& other)
+            : _origin(other._origin)
+            , _in(other._in.clone())
+            , _format(other._format)
+            , _detected(other._detected)
+            , _stage(other._stage)
+            , _final(other._final)
+            , _stored_left(other._stored_left)
+            , _lit(other._lit)
+            , _dist(other._dist)
+            , _checksum(other._checksum)
+            , _member_start(other._member_start)
+            , _out(other._out)
+            , _out_start(other._out_start)
+            , _filled(other._filled)
+            , _checked(other._checked)
+            , _cursor(other._cursor)
+        {
+        }
+
+        //----------------------------------------------------------------------
+        uint64_t _end() const
+        {
+            return _out_start + _filled;
+        }
+
+        //----------------------------------------------------------------------
+        void _advance(uint64_t position)
+        {
+            if (position < _out_start) {
+                _restart();
+            }
+
+            while (_end() < position && _stage != stage::done) {
+                _cursor = _end();
+                _produce(std::min(position, _cursor + OutputChunk));
+            }
+        }
+
+        //----------------------------------------------------------------------
+        void _restart()
+        {
+            auto source = _in.source().clone();
+            source->seek(_origin);
+            _in = lsb_bitreader<Source>(std::move(source));
+            _stage = stage::header;
+            _final = false;
+            _out_start = 0;
+            _filled = 0;
+            _checked = 0;
+            _cursor = 0;
+            _member_start = 0;
+        }
+
+        //----------------------------------------------------------------------
+        [[noreturn]] static void _fail(const char* what)
+        {
+            throw std::runtime_error(std::string("Invalid deflate data: ") + what);
+        }
+
+        //----------------------------------------------------------------------
+        uint32_t _bits(size_t count)
+        {
+            if (_in.available() < count) {
+                _fail("unexpected end of compressed stream");
+            }
+            return _in.template read<uint32_t>(count);
+        }
+
+        //----------------------------------------------------------------------
+        void _produce(uint64_t target)
+        {
+            while (_end() < target && _stage != stage::done) {
+                switch (_stage) {
+                    case stage::header: _read_header(); break;
+                    case stage::block: _read_block_header(); break;
+                    case stage::stored: _copy_stored(target); break;
+                    case stage::huffman: _decode_huffman(target); break;
+                    case stage::trailer: _read_trailer(); break;
+                    case stage::done: break;
+                }
+            }
+        }
+
+        //----------------------------------------------------------------------
+        void _make_room(size_t bytes)
+        {
+            if (_filled + bytes <= _out.size()) {
+                return;
+            }
+
+            _update_checksum();
+
+            // Keep the LZ77 history and anything not read yet
+            auto unread_from = static_cast<size_t>(std::max(_cursor, _out_start) - _out_start);
+            auto history_from = _filled > HistorySize ? _filled - HistorySize : 0;
+            auto discard = std::min(unread_from, history_from);
+            if (discard == 0) {
+                throw std::logic_error("Inflate window overflow");
+            }
+
+            std::memmove(_out.data(), _out.data() + discard, _filled - discard);
+            _out_start += discard;
+            _filled -= discard;
+            _checked -= discard;
+        }
+
+        //----------------------------------------------------------------------
+        void _update_checksum()
+        {
+            auto data = _out.data() + _checked;
+            auto size = _filled - _checked;
+            if (_detected == format::gzip) {
+                _checksum = detail::inflate_checksum::crc32(_checksum, data, size);
+            } else if (_detected == format::zlib) {
+                _checksum = detail::inflate_checksum::adler32(_checksum, data, size);
+            }
+            _checked = _filled;
+        }
+
+        //----------------------------------------------------------------------
+        void _read_header()
+        {
+            _detected = _format;
+            if (_detected == format::automatic) {
+                auto magic = _in.peek_padded(16);
+                auto b0 = magic & 0xFF;
+                auto b1 = magic >> 8;
+                if (_in.available() >= 16 && b0 == 0x1F && b1 == 0x8B) {
+                    _detected = format::gzip;
+                } else if ((b0 & 0x0F) == 8 && (b0 >> 4) <= 7 && ((b0 << 8) | b1) % 31 == 0) {
+                    _detected = format::zlib;
+                } else {
+                    _detected = format::raw;
+                }
+            }
+
+            if (_detected == format::zlib) {
+                auto cmf = _bits(8);
+                auto flg = _bits(8);
+                if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0) {
+                    _fail("bad zlib header");
+                }
+                if (flg & 0x20) {
+                    _fail("preset dictionaries are not supported");
+                }
+                _checksum = 1;
+            } else if (_detected == format::gzip) {
+                _read_gzip_header();
+                _checksum = 0;
+            }
+
+            _final = false;
+            _stage = stage::block;
+        }
+
+        //----------------------------------------------------------------------
+        void _read_gzip_header()
+        {
+            if (_bits(8) != 0x1F || _bits(8) != 0x8B || _bits(8) != 8) {
+                _fail("bad gzip header");
+            }
+
+            auto flags = _bits(8);
+            if (flags & 0xE0) {
+                _fail("reserved gzip flags set");
+            }
+
+            _bits(32); // MTIME
+            _bits(16); // XFL, OS
+
+            if (flags & 0x04) { // FEXTRA
+                auto length = _bits(16);
+                for (uint32_t iter = 0; iter < length; ++iter) {
+                    _bits(8);
+                }
+            }
+
+            if (flags & 0x08) { // FNAME
+                while (_bits(8) != 0) {}
+            }
+
+            if (flags & 0x10) { // FCOMMENT
+                while (_bits(8) != 0) {}
+            }
+
+            if (flags & 0x02) { // FHCRC
+                _bits(16);
+            }
+        }
+
+        //----------------------------------------------------------------------
+        void _read_block_header()
+        {
+            if (_final) {
+                _stage = stage::trailer;
+                return;
+            }
+
+            _final = _bits(1) != 0;
+            switch (_bits(2)) {
+                case 0: {
+                    _in.align(8);
+                    auto length = _bits(16);
+                    auto complement = _bits(16);
+                    if ((length ^ 0xFFFF) != complement) {
+                        _fail("stored block length mismatch");
+                    }
+                    _stored_left = length;
+                    _stage = stage::stored;
+                    break;
+                }
+                case 1:
+                    _use_fixed_tables();
+                    _stage = stage::huffman;
+                    break;
+                case 2:
+                    _read_dynamic_tables();
+                    _stage = stage::huffman;
+                    break;
+                default:
+                    _fail("invalid block type");
+            }
+        }
+
+        //----------------------------------------------------------------------
+        void _copy_stored(uint64_t target)
+        {
+            if (_stored_left == 0) {
+                _stage = stage::block;
+                return;
+            }
+
+            auto wanted = std::max<uint64_t>(target - _end(), 1);
+            auto chunk = static_cast<size_t>(std::min<uint64_t>({
+                    wanted, _stored_left, OutputChunk}));
+
+            _make_room(chunk);
+            if (_in.available() < chunk * 8) {
+                _fail("unexpected end of compressed stream");
+            }
+
+            _in.read_bytes(_out.data() + _filled, chunk);
+            _filled += chunk;
+            _stored_left -= chunk;
+        }
+
+        //----------------------------------------------------------------------
+        void _use_fixed_tables()
+        {
+            static const auto tables = [] {
+                std::array<uint8_t, 288> lengths{};
+                std::fill(lengths.begin(), lengths.begin() + 144, 8);
+                std::fill(lengths.begin() + 144, lengths.begin() + 256, 9);
+                std::fill(lengths.begin() + 256, lengths.begin() + 280, 7);
+                std::fill(lengths.begin() + 280, lengths.end(), 8);
+
+                std::array<uint8_t, 30> distances{};
+                distances.fill(5);
+
+                std::pair<detail::inflate_table, detail::inflate_table> ret;
+                ret.first.build(lengths.data(), lengths.size());
+                ret.second.build(distances.data(), distances.size());
+                return ret;
+            }();
+
+            _lit = tables.first;
+            _dist = tables.second;
+        }
+
+        //----------------------------------------------------------------------
+        void _read_dynamic_tables()
+        {
+            static constexpr uint8_t order[19] = {
+                16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+            };
+
+            const size_t nlen = _bits(5) + 257;
+            const size_t ndist = _bits(5) + 1;
+            const size_t ncode = _bits(4) + 4;
+            if (nlen > 286 || ndist > 30) {
+                _fail("too many length or distance codes");
+            }
+
+            std::array<uint8_t, 19> code_lengths{};
+            for (size_t iter = 0; iter < ncode; ++iter) {
+                code_lengths[order[iter]] = static_cast<uint8_t>(_bits(3));
+            }
+
+            detail::inflate_table codes;
+            codes.build(code_lengths.data(), code_lengths.size());
+
+            std::array<uint8_t, 286 + 30> lengths{};
+            size_t index = 0;
+            while (index < nlen + ndist) {
+                auto symbol = _decode(codes);
+                if (symbol < 16) {
+                    lengths[index++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                uint8_t value = 0;
+                size_t repeat = 0;
+                if (symbol == 16) {
+                    if (index == 0) {
+                        _fail("repeat with no previous length");
+                    }
+                    value = lengths[index - 1];
+                    repeat = 3 + _bits(2);
+                } else if (symbol == 17) {
+                    repeat = 3 + _bits(3);
+                } else {
+                    repeat = 11 + _bits(7);
+                }
+
+                if (index + repeat > nlen + ndist) {
+                    _fail("too many code lengths");
+                }
+                std::fill_n(lengths.begin() + static_cast<ptrdiff_t>(index), repeat, value);
+                index += repeat;
+            }
+
+            if (lengths[256] == 0) {
+                _fail("missing end-of-block code");
+            }
+
+            _lit.build(lengths.data(), nlen);
+            _dist.build(lengths.data() + nlen, ndist);
+        }
+
+        //----------------------------------------------------------------------
+        size_t _decode(const detail::inflate_table& table)
+        {
+            using table_t = detail::inflate_table;
+            const auto bits = _in.peek_padded(table_t::MaxBits);
+            const auto available = _in.available();
+
+            const auto entry = table.fast[bits & ((uint64_t(1) << table_t::FastBits) - 1)];
+            if (entry != 0) {
+                const size_t length = entry & 0x0F;
+                if (length > available) {
+                    _fail("unexpected end of compressed stream");
+                }
+                _in.skip(length);
+                return entry >> 4;
+            }
+
+            // Slow path: walk the canonical code one length at a time
+            int code = 0;
+            int first = 0;
+            int index = 0;
+            for (size_t length = 1; length <= table_t::MaxBits; ++length) {
+                code |= static_cast<int>((bits >> (length - 1)) & 1);
+                const int count = table.count[length];
+                if (code - count < first) {
+                    if (length > available) {
+                        _fail("unexpected end of compressed stream");
+                    }
+                    _in.skip(length);
+                    return table.symbols[static_cast<size_t>(index + (code - first))];
+                }
+                index += count;
+                first += count;
+                first <<= 1;
+                code <<= 1;
+            }
+
+            _fail("invalid Huffman code");
+        }
+
+        //----------------------------------------------------------------------
+        void _decode_huffman(uint64_t target)
+        {
+            static constexpr uint16_t length_base[29] = {
+                3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+            };
+            static constexpr uint8_t length_extra[29] = {
+                0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+            };
+            static constexpr uint16_t dist_base[30] = {
+                1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                8193, 12289, 16385, 24577
+            };
+            static constexpr uint8_t dist_extra[30] = {
+                0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+            };
+
+            while (_end() < target) {
+                _make_room(MaxMatch);
+
+                const auto symbol = _decode(_lit);
+                if (symbol < 256) {
+                    _out[_filled++] = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                if (symbol == 256) {
+                    _stage = stage::block;
+                    return;
+                }
+
+                const auto length_code = symbol - 257;
+                if (length_code >= 29) {
+                    _fail("invalid length code");
+                }
+                const size_t length = length_base[length_code] + _bits(length_extra[length_code]);
+
+                const auto dist_code = _decode(_dist);
+                if (dist_code >= 30) {
+                    _fail("invalid distance code");
+                }
+                const size_t distance = dist_base[dist_code] + _bits(dist_extra[dist_code]);
+                if (distance > _filled) {
+                    _fail("distance too far back");
+                }
+
+                // Byte by byte on purpose: overlapping copies repeat the pattern
+                uint8_t* dest = _out.data() + _filled;
+                const uint8_t* from = dest - distance;
+                for (size_t iter = 0; iter < length; ++iter) {
+                    dest[iter] = from[iter];
+                }
+                _filled += length;
+            }
+        }
+
+        //----------------------------------------------------------------------
+        void _read_trailer()
+        {
+            _update_checksum();
+            _in.align(8);
+
+            if (_detected == format::zlib) {
+                uint32_t expected = 0;
+                for (int iter = 0; iter < 4; ++iter) {
+                    expected = (expected << 8) | _bits(8);
+                }
+                if (expected != _checksum) {
+                    _fail("zlib checksum mismatch");
+                }
+            } else if (_detected == format::gzip) {
+                auto crc = _bits(32);
+                auto size = _bits(32);
+                if (crc != _checksum) {
+                    _fail("gzip CRC mismatch");
+                }
+                if (size != static_cast<uint32_t>(_end() - _member_start)) {
+                    _fail("gzip size mismatch");
+                }
+
+                // Concatenated gzip members form a single stream
+                auto magic = _in.peek_padded(16);
+                if (_in.available() >= 16 && magic == 0x8B1F) {
+                    _member_start = _end();
+                    _stage = stage::header;
+                    return;
+                }
+            }
+
+            _stage = stage::done;
+        }
+
+        uint64_t _origin;
+        lsb_bitreader<Source> _in;
+        format _format;
+        format _detected = format::raw;
+
+        stage _stage = stage::header;
+        bool _final = false;
+        uint64_t _stored_left = 0;
+        detail::inflate_table _lit;
+        detail::inflate_table _dist;
+        uint32_t _checksum = 0;
+        uint64_t _member_start = 0;
+
+        std::vector<uint8_t> _out;
+        uint64_t _out_start = 0;    // stream offset of _out[0]
+        size_t _filled = 0;         // decoded bytes in _out
+        size_t _checked = 0;        // bytes of _out already checksummed
+        uint64_t _cursor = 0;       // read position in the inflated stream
+    };
+}
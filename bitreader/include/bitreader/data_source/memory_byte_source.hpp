@@ -6,20 +6,61 @@
 
 namespace brcpp
 {
+    //--------------------------------------------------------------------------
+    struct borrow_memory_t
+    {
+        explicit borrow_memory_t() = default;
+    };
+
+    inline constexpr borrow_memory_t borrow_memory{};
+
+    //--------------------------------------------------------------------------
     class memory_byte_source
     {
     public:
+        static constexpr const bool random_access = true;
+
         memory_byte_source();
+
+        /**
+         * @brief Read from a private copy of the data
+         */
         memory_byte_source(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Read from caller-owned memory without copying it.
+         *        The memory must outlive the source and all its clones.
+         */
+        memory_byte_source(borrow_memory_t, const uint8_t* data, size_t size);
+
+        /**
+         * @brief Read from the buffer without copying, sharing its ownership.
+         *        Only the bytes within buffer.size() at this point are used.
+         */
+        explicit memory_byte_source(shared_buffer data);
+
+        memory_byte_source(const memory_byte_source&) = default;
+        memory_byte_source& operator=(const memory_byte_source&) = default;
+
         size_t get_n(uint64_t& buf, size_t bytes);
         bool depleted();
         uint64_t available();
         uint64_t position();
         void seek(uint64_t position);
         void skip(uint64_t bytes);
+
+        /**
+         * @return A source over the same data with its own position; O(1)
+         */
         std::shared_ptr<memory_byte_source> clone();
+
+        const uint8_t* data() const { return _begin; }
+        uint64_t size() const { return static_cast<uint64_t>(_end - _begin); }
+
     private:
-        shared_buffer::iterator _current;
         shared_buffer _data;
+        const uint8_t* _begin;
+        const uint8_t* _end;
+        const uint8_t* _current;
     };
 }
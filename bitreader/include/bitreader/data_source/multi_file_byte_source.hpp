@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "bitreader/common/file_reader.hpp"
+#include "bitreader/data_source/file_byte_source.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief Byte source presenting a sequence of files (e.g. a recording
+     *        rolled over into rec.000, rec.001, ...) as one seekable stream.
+     *
+     * Positions are global over the concatenation. Only the segment being
+     * read and the one left last hold a window, so stepping back and forth
+     * over a boundary does not reload; when the position gets within
+     * PrefetchDistance of its end, the next file is asked to prefetch its
+     * beginning. Clones open their own readers when they first need them.
+     */
+    class multi_file_byte_source
+    {
+    public:
+        static constexpr const bool random_access = true;
+        static constexpr const size_t PrefetchDistance = 256 * 1024;
+
+        explicit multi_file_byte_source(std::vector<std::shared_ptr<file_reader>> readers);
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<multi_file_byte_source> clone();
+
+        /**
+         * @return Index of the file the current position belongs to
+         */
+        size_t segment() const { return _segment; }
+
+    private:
+        multi_file_byte_source(
+                std::vector<std::shared_ptr<file_reader>> readers,
+                std::vector<uint64_t> offsets);
+
+        std::shared_ptr<file_reader> reader(size_t segment);
+        void enter(size_t segment);
+        void prefetch_next();
+        uint64_t size() const { return _offsets.back(); }
+
+        std::vector<std::shared_ptr<file_reader>> _readers;
+        std::vector<bool> _owned;       // false while shared with the original
+        std::vector<uint64_t> _offsets; // file starts, plus the total size
+        std::shared_ptr<file_byte_source> _current;
+        std::shared_ptr<file_byte_source> _previous;
+        size_t _segment = 0;
+        size_t _previous_segment = 0;
+        uint64_t _position = 0;
+        size_t _prefetched = 0;         // last segment asked to prefetch
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <optional>
+
+namespace brcpp
+{
+    /**
+     * @brief Forward-only byte source over a file descriptor or an
+     *        std::istream, e.g. stdin or a pipe.
+     *
+     * Data is read into a ring buffer on demand (reads block). The last
+     * look_behind bytes before the furthest position read stay reachable
+     * by seek(), anything older is gone. The total size is unknown until
+     * the end of input, so available() only reports what is buffered
+     * ahead (see lazy_byte_source), waiting only if that is nothing, and
+     * skip() reads through the input.
+     * A seek past the end leaves the position unchanged, though reading
+     * through may have dropped it from the look-behind window.
+     *
+     * Clones share the ring buffer and the input, each keeping its own
+     * position; a clone lagging behind by more than look_behind bytes
+     * can no longer read.
+     */
+    class pipe_byte_source
+    {
+    public:
+        static constexpr const bool available_is_lower_bound = true;
+        static constexpr const size_t DefaultLookBehind = 64 * 1024;
+
+        /**
+         * @brief Read from a file descriptor, which is not closed by the source
+         */
+        explicit pipe_byte_source(int fd, size_t look_behind = DefaultLookBehind);
+
+        /**
+         * @brief Read from a stream, which must outlive the source and its clones
+         */
+        explicit pipe_byte_source(std::istream& stream, size_t look_behind = DefaultLookBehind);
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<pipe_byte_source> clone();
+
+        /**
+         * @return The total size, known once the end of input has been reached
+         */
+        std::optional<uint64_t> size() const;
+
+    private:
+        struct ring;
+
+        explicit pipe_byte_source(std::shared_ptr<ring> ring);
+
+        std::shared_ptr<ring> _ring;
+        uint64_t _position = 0;
+    };
+}
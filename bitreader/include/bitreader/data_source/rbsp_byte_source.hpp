@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_source/memory_byte_source.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief Byte source over an H.264/HEVC NAL unit payload that drops
+     *        emulation prevention bytes (the 03 in 00 00 03) on the fly,
+     *        presenting the RBSP without copying it.
+     *
+     * The escapes are located as reading goes, a chunk ahead at a time
+     * with a vectorized scan, and remembered for seeking back; reads copy
+     * straight through the runs between them. Parsing just a slice header
+     * therefore never looks at the rest of the slice. Until the scan has
+     * reached the end the RBSP size is unknown, so available() only
+     * reports what has been scanned (see lazy_byte_source).
+     *
+     * Positions are RBSP offsets, original_position() maps them back to
+     * the escaped data.
+     */
+    class rbsp_byte_source
+    {
+    public:
+        static constexpr const bool available_is_lower_bound = true;
+        static constexpr const bool random_access = true;
+
+        rbsp_byte_source();
+
+        /**
+         * @brief Read from a private copy of the data
+         */
+        rbsp_byte_source(const uint8_t* data, size_t size);
+
+        /**
+         * @brief Read from caller-owned memory without copying it.
+         *        The memory must outlive the source and all its clones.
+         */
+        rbsp_byte_source(borrow_memory_t, const uint8_t* data, size_t size);
+
+        /**
+         * @brief Read from the buffer without copying, sharing its ownership
+         */
+        explicit rbsp_byte_source(shared_buffer data);
+
+        rbsp_byte_source(const rbsp_byte_source&) = default;
+        rbsp_byte_source& operator=(const rbsp_byte_source&) = default;
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<rbsp_byte_source> clone();
+
+        /**
+         * @return Offset in the escaped data of the byte at the given RBSP position
+         */
+        uint64_t original_position(uint64_t position);
+
+        /**
+         * @return Offset in the escaped data of the next byte to be read
+         */
+        uint64_t original_position() const
+        {
+            return static_cast<uint64_t>(_current - _begin);
+        }
+
+        /**
+         * @return The number of emulation prevention bytes in the data,
+         *         which scans the rest of it
+         */
+        size_t escapes();
+
+    private:
+        void scan_to(uint64_t limit);
+        size_t escapes_before(uint64_t position);
+        size_t known_escapes_before(uint64_t position) const;
+        const uint8_t* next_escape() const;
+        uint64_t original_size() const;
+
+        shared_buffer _data;
+        const uint8_t* _begin;
+        const uint8_t* _end;
+        const uint8_t* _current;
+
+        // Offsets of the emulation prevention bytes in the escaped data,
+        // complete for everything before _scanned
+        std::vector<uint64_t> _escapes;
+        uint64_t _scanned = 0;
+        size_t _next_escape = 0;
+        uint64_t _position = 0;
+    };
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "bitreader/common/shared_buffer.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief Byte source over a chain of buffers read as one contiguous
+     *        stream, without concatenating them.
+     *
+     * Seeking is O(log n) in the number of segments, clones share the
+     * segments and only copy the cursor.
+     */
+    class segmented_byte_source
+    {
+    public:
+        static constexpr const bool random_access = true;
+
+        segmented_byte_source();
+        explicit segmented_byte_source(std::vector<shared_buffer> segments);
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<segmented_byte_source> clone();
+
+        size_t segments() const { return _layout->segments.size(); }
+
+    private:
+        //----------------------------------------------------------------------
+        struct layout
+        {
+            std::vector<shared_buffer> segments;
+            std::vector<uint64_t> offsets; // segment starts, plus the total size
+        };
+
+        void enter(size_t segment, size_t offset);
+        uint64_t size() const { return _layout->offsets.back(); }
+
+        std::shared_ptr<const layout> _layout;
+        size_t _segment = 0;
+        const uint8_t* _current = nullptr;
+        const uint8_t* _segment_end = nullptr;
+    };
+}
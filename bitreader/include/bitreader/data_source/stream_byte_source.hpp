@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <memory>
+
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_source/byte_source.hpp"
+
+namespace brcpp
+{
+    /**
+     * @brief Byte source for data that arrives in chunks (pipes, sockets,
+     *        growing captures).
+     *
+     * Running out of pushed data throws need_more_data until finish() is
+     * called; after that the source behaves like any other depleted one.
+     * Consumed chunks are dropped, except for the last look_behind bytes
+     * before the current position, which stay reachable by seek().
+     */
+    class stream_byte_source
+    {
+    public:
+        static constexpr const size_t DefaultLookBehind = 64;
+
+        stream_byte_source();
+        explicit stream_byte_source(size_t look_behind);
+
+        void push(const uint8_t* data, size_t size);
+        void push(shared_buffer chunk);
+        void finish();
+        bool finished() const { return _finished; }
+
+        /**
+         * @return Number of bytes currently held by the source
+         */
+        uint64_t buffered() const { return _end - _base; }
+
+        size_t get_n(uint64_t& buf, size_t bytes);
+        bool depleted();
+        uint64_t available();
+        uint64_t position();
+        void seek(uint64_t position);
+        void skip(uint64_t bytes);
+        std::shared_ptr<stream_byte_source> clone();
+
+    private:
+        void locate(uint64_t position);
+        void trim();
+        void underflow(const char* message) const;
+
+        size_t _look_behind;
+        std::deque<shared_buffer> _chunks;
+        uint64_t _base = 0;     // stream offset of the first retained chunk
+        uint64_t _end = 0;      // stream offset right past the last chunk
+        uint64_t _position = 0;
+        size_t _chunk = 0;      // chunk containing the position
+        size_t _offset = 0;     // offset of the position in that chunk
+        bool _finished = false;
+    };
+}
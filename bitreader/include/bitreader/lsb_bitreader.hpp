@@ -0,0 +1,192 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+
+#include "bitreader/bitreader-utils.hpp"
+#include "common/numeric.hpp"
+#include "data_source/byte_source.hpp"
+
+namespace brcpp {
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Bit reader for LSB-first formats (DEFLATE, LZ-style codecs etc.),
+     *        where the first bit of the stream is the least significant bit
+     *        of the first byte and multi-bit fields are little-endian.
+     */
+    template<byte_source Source>
+    class lsb_bitreader {
+    public:
+        explicit lsb_bitreader(std::shared_ptr<Source> source)
+            : _source(std::move(source))
+        {
+        }
+
+        lsb_bitreader(lsb_bitreader&&) noexcept = default;
+        lsb_bitreader& operator=(lsb_bitreader&&) noexcept = default;
+        lsb_bitreader(const lsb_bitreader&) = delete;
+        lsb_bitreader& operator=(const lsb_bitreader&) = delete;
+
+        /**
+         * @return A reader at the same position over a clone of the source
+         */
+        lsb_bitreader clone() const
+        {
+            lsb_bitreader ret(_source->clone());
+            ret._buffer = _buffer;
+            ret._count = _count;
+            return ret;
+        }
+
+        Source& source()
+        {
+            return *_source;
+        }
+
+        /**
+         * @return Current position in the input stream (in bits)
+         */
+        size_t position() const
+        {
+            return _source->position() * 8 - _count;
+        }
+
+        /**
+         * @return The number of bits available for reading
+         */
+        size_t available() const
+        {
+            return _source->available() * 8 + _count;
+        }
+
+        //----------------------------------------------------------------------
+        template<unsigned_integral T = uint32_t>
+        T read(size_t bits)
+        {
+            if (bits > bit_read_helper<T>::max_bits) {
+                throw std::runtime_error("Invalid read size");
+            }
+
+            if (bits > MaxChunk) {
+                auto low = static_cast<uint64_t>(read<T>(32));
+                auto high = static_cast<uint64_t>(read<T>(bits - 32));
+                return static_cast<T>(low | (high << 32));
+            }
+
+            _refill();
+            if (_count < bits) {
+                throw std::runtime_error("Cannot read beyond the bitstream data");
+            }
+
+            auto ret = static_cast<T>(_buffer & _mask(bits));
+            _consume(bits);
+            return ret;
+        }
+
+        /**
+         * @brief Next bits of the stream without consuming them; bits past
+         *        the end of the stream read as zeros.
+         */
+        uint64_t peek_padded(size_t bits)
+        {
+            _refill();
+            return _buffer & _mask(bits);
+        }
+
+        void skip(size_t bits)
+        {
+            if (available() < bits) {
+                throw std::runtime_error("Cannot skip beyond end of bitstream");
+            }
+
+            if (bits <= _count) {
+                _consume(bits);
+            } else {
+                bits -= _count;
+                _consume(_count);
+                _source->skip(bits / 8);
+                _refill();
+                _consume(bits % 8);
+            }
+        }
+
+        void align(size_t bits)
+        {
+            size_t advance = (bits - (position() % bits)) % bits;
+            if (advance > 0) {
+                skip(advance);
+            }
+        }
+
+        /**
+         * @brief Copy whole bytes out of a byte-aligned stream
+         */
+        void read_bytes(uint8_t* dest, size_t bytes)
+        {
+            if (_count % 8 != 0) {
+                throw std::runtime_error("Byte reads require byte alignment");
+            }
+
+            if (available() < bytes * 8) {
+                throw std::runtime_error("Cannot read beyond the bitstream data");
+            }
+
+            while (bytes > 0 && _count > 0) {
+                *dest++ = static_cast<uint8_t>(_buffer);
+                _consume(8);
+                --bytes;
+            }
+
+            while (bytes > 0) {
+                uint64_t chunk = 0;
+                auto got = _source->get_n(chunk, std::min<size_t>(bytes, 8));
+                for (size_t iter = got; iter > 0; --iter) {
+                    *dest++ = static_cast<uint8_t>(chunk >> (8 * (iter - 1)));
+                }
+                bytes -= got;
+            }
+        }
+
+    private:
+        static constexpr const size_t MaxChunk = 56;
+
+        //----------------------------------------------------------------------
+        static constexpr uint64_t _mask(size_t bits)
+        {
+            return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        }
+
+        //----------------------------------------------------------------------
+        void _consume(size_t bits)
+        {
+            _buffer = bits >= 64 ? 0 : _buffer >> bits;
+            _count -= bits;
+        }
+
+        //----------------------------------------------------------------------
+        void _refill()
+        {
+            if (_count > MaxChunk) {
+                return;
+            }
+
+            auto to_read = std::min<uint64_t>((64 - _count) / 8, _source->available());
+            if (to_read == 0) {
+                return;
+            }
+
+            // get_n packs bytes MSB-first, swap them into stream order
+            uint64_t chunk = 0;
+            auto got = _source->get_n(chunk, static_cast<size_t>(to_read));
+            auto ordered = byteswap64(chunk) >> (64 - 8 * got);
+            _buffer |= ordered << _count;
+            _count += 8 * got;
+        }
+
+        std::shared_ptr<Source> _source;
+        uint64_t _buffer = 0;
+        size_t _count = 0;
+    };
+}
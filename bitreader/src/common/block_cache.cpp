@@ -0,0 +1,87 @@
+#include "bitreader/common/block_cache.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+block_cache::block_cache(size_t block_size, size_t budget)
+        : _block_size(block_size)
+        , _budget(budget)
+{
+    if (_block_size == 0) {
+        throw std::invalid_argument("Cache block size must be non-zero");
+    }
+}
+
+//----------------------------------------------------------------------
+shared_buffer block_cache::get(uint64_t file, uint64_t block, file_reader& reader)
+{
+    const key k{file, block};
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        auto found = _blocks.find(k);
+        if (found != _blocks.end()) {
+            ++_stats.hits;
+            _lru.splice(_lru.begin(), _lru, found->second.lru);
+            return found->second.data;
+        }
+        ++_stats.misses;
+    }
+
+    // Do the I/O without holding the lock; if another thread loads the
+    // same block meanwhile, the first one to finish wins
+    const auto alignment = std::max<size_t>(reader.alignment(), 1);
+    auto data = alignment > 1
+            ? shared_buffer::allocate(_block_size, alignment)
+            : shared_buffer::allocate(_block_size);
+
+    auto read = reader.read(data.get(), block * _block_size, _block_size);
+    data.resize(read);
+
+    std::lock_guard<std::mutex> guard(_lock);
+    auto [iter, inserted] = _blocks.try_emplace(k, entry{data, {}});
+    if (!inserted) {
+        return iter->second.data;
+    }
+
+    _lru.push_front(k);
+    iter->second.lru = _lru.begin();
+    _stats.memory += data.capacity();
+    evict();
+    return data;
+}
+
+//----------------------------------------------------------------------
+uint64_t block_cache::register_file()
+{
+    return _next_file++;
+}
+
+//----------------------------------------------------------------------
+void block_cache::clear()
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _blocks.clear();
+    _lru.clear();
+    _stats.memory = 0;
+}
+
+//----------------------------------------------------------------------
+block_cache::statistics block_cache::stats() const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _stats;
+}
+
+//----------------------------------------------------------------------
+void block_cache::evict()
+{
+    while (_stats.memory > _budget && !_lru.empty()) {
+        auto found = _blocks.find(_lru.back());
+        _stats.memory -= found->second.data.capacity();
+        _blocks.erase(found);
+        _lru.pop_back();
+        ++_stats.evictions;
+    }
+}
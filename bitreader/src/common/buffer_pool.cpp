@@ -0,0 +1,157 @@
+#include "bitreader/common/buffer_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    std::atomic<uint64_t> next_pool{1};
+    std::atomic<size_t> next_thread{0};
+
+    // Threads are dealt shards round robin, the same one in every pool
+    thread_local const size_t thread_shard =
+            next_thread.fetch_add(1, std::memory_order_relaxed) % buffer_pool::CacheShards;
+}
+
+//----------------------------------------------------------------------
+buffer_pool::buffer_pool(
+        size_t buffer_size,
+        size_t alignment,
+        size_t max_buffers,
+        std::pmr::memory_resource* resource)
+        : _id(next_pool.fetch_add(1, std::memory_order_relaxed))
+        , _buffer_size(buffer_size)
+        , _alignment(alignment)
+        , _max_buffers(max_buffers)
+        , _resource(resource ? resource : std::pmr::get_default_resource())
+{
+    if (buffer_size == 0) {
+        throw std::invalid_argument("Pool buffer size must not be zero");
+    }
+}
+
+//----------------------------------------------------------------------
+shared_buffer buffer_pool::acquire()
+{
+    return acquire(_buffer_size);
+}
+
+//----------------------------------------------------------------------
+shared_buffer buffer_pool::acquire(size_t size)
+{
+    const auto index = size_class(size);
+    if (index == SizeClasses) {
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        return shared_buffer::allocate(size, _alignment, _resource);
+    }
+
+    count_acquire();
+
+    {
+        auto& shard = local_shard();
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if (shard.count[index] > 0) {
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            return std::move(shard.slots[index][--shard.count[index]]);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        auto& free = _free[index];
+        if (!free.empty()) {
+            auto ret = std::move(free.back());
+            free.pop_back();
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            return ret;
+        }
+    }
+
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return allocate(size);
+}
+
+//----------------------------------------------------------------------
+void buffer_pool::release(shared_buffer buffer)
+{
+    if (!buffer || buffer.is_slice()) {
+        return;
+    }
+
+    // Anything not allocated here would throw the accounting off
+    const auto index = size_class(buffer.capacity());
+    if (index == SizeClasses || buffer._state->pool != _id) {
+        return;
+    }
+
+    _in_use.fetch_sub(1, std::memory_order_relaxed);
+    buffer.resize(0);
+
+    {
+        auto& shard = local_shard();
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if (shard.count[index] < std::min(ThreadCacheSize, _max_buffers)) {
+            shard.slots[index][shard.count[index]++] = std::move(buffer);
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(_lock);
+    auto& free = _free[index];
+    if (free.size() < _max_buffers) {
+        free.push_back(std::move(buffer));
+    }
+}
+
+//----------------------------------------------------------------------
+buffer_pool::statistics buffer_pool::stats() const
+{
+    statistics ret;
+    ret.hits = _hits.load(std::memory_order_relaxed);
+    ret.misses = _misses.load(std::memory_order_relaxed);
+    ret.in_use = _in_use.load(std::memory_order_relaxed);
+    ret.high_water = _high_water.load(std::memory_order_relaxed);
+    return ret;
+}
+
+//----------------------------------------------------------------------
+buffer_pool::cache_shard& buffer_pool::local_shard()
+{
+    return _shards[thread_shard];
+}
+
+//----------------------------------------------------------------------
+size_t buffer_pool::size_class(size_t size) const
+{
+    for (size_t index = 0; index < SizeClasses; ++index) {
+        auto class_size = _buffer_size << index;
+        if (class_size == size) {
+            return index;
+        } else if (class_size > size) {
+            break;
+        }
+    }
+
+    return SizeClasses;
+}
+
+//----------------------------------------------------------------------
+shared_buffer buffer_pool::allocate(size_t size) const
+{
+    auto ret = shared_buffer::allocate(size, _alignment, _resource);
+    ret._state->pool = _id;
+    return ret;
+}
+
+//----------------------------------------------------------------------
+void buffer_pool::count_acquire()
+{
+    auto in_use = _in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+    auto high_water = _high_water.load(std::memory_order_relaxed);
+    while (in_use > high_water &&
+           !_high_water.compare_exchange_weak(high_water, in_use, std::memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,258 @@
+#include "bitreader/common/byte_scan.hpp"
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BRCPP_SCAN_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BRCPP_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace brcpp;
+
+namespace
+{
+#if defined(BRCPP_SCAN_SSE2) || defined(BRCPP_SCAN_NEON)
+    constexpr const size_t Lanes = 16;
+#endif
+
+#if defined(BRCPP_SCAN_SSE2)
+    //--------------------------------------------------------------------------
+    // Bit N is set when p[N] == first and p[N + gap] == last
+    uint64_t candidates(const uint8_t* p, size_t gap, uint8_t first, uint8_t last)
+    {
+        auto head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        auto tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + gap));
+        auto match = _mm_and_si128(
+                _mm_cmpeq_epi8(head, _mm_set1_epi8(static_cast<char>(first))),
+                _mm_cmpeq_epi8(tail, _mm_set1_epi8(static_cast<char>(last))));
+        return static_cast<uint32_t>(_mm_movemask_epi8(match));
+    }
+
+    constexpr const size_t BitsPerLane = 1;
+#elif defined(BRCPP_SCAN_NEON)
+    //--------------------------------------------------------------------------
+    // Four bits per lane: NEON has no movemask, narrowing is the cheap way
+    uint64_t candidates(const uint8_t* p, size_t gap, uint8_t first, uint8_t last)
+    {
+        auto match = vandq_u8(
+                vceqq_u8(vld1q_u8(p), vdupq_n_u8(first)),
+                vceqq_u8(vld1q_u8(p + gap), vdupq_n_u8(last)));
+        auto narrowed = vshrn_n_u16(vreinterpretq_u16_u8(match), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x1111111111111111ull;
+    }
+
+    constexpr const size_t BitsPerLane = 4;
+#endif
+
+#if defined(BRCPP_SCAN_SSE2)
+    //--------------------------------------------------------------------------
+    // Keep the low bits of every value, values being width bytes wide
+    __m128i mask_values(__m128i v, size_t width, uint64_t mask)
+    {
+        switch (width) {
+        case 1:
+            return _mm_and_si128(v, _mm_set1_epi8(static_cast<char>(mask)));
+        case 2:
+            return _mm_and_si128(v, _mm_set1_epi16(static_cast<short>(mask)));
+        default:
+            return _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(mask)));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Neighbouring values merge into one twice as wide, the first on top
+    __m128i merge_pairs(__m128i v, size_t width, size_t bits)
+    {
+        auto count = _mm_cvtsi32_si128(static_cast<int>(bits));
+        switch (width) {
+        case 1:
+            return _mm_or_si128(
+                    _mm_sll_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), count),
+                    _mm_srli_epi16(v, 8));
+        case 2:
+            return _mm_or_si128(
+                    _mm_sll_epi32(_mm_and_si128(v, _mm_set1_epi32(0x0000ffff)), count),
+                    _mm_srli_epi32(v, 16));
+        default:
+            return _mm_or_si128(
+                    _mm_sll_epi64(_mm_and_si128(v, _mm_set1_epi64x(0xffffffffll)), count),
+                    _mm_srli_epi64(v, 32));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Two words of packed values out of 16 bytes of them
+    void pack_vector(const uint8_t* values, size_t width, size_t bits, uint64_t mask, uint64_t* words)
+    {
+        auto v = mask_values(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values)), width, mask);
+        for (; width < sizeof(uint64_t); width *= 2, bits *= 2) {
+            v = merge_pairs(v, width, bits);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(words), v);
+    }
+#elif defined(BRCPP_SCAN_NEON)
+    //--------------------------------------------------------------------------
+    // Keep the low bits of every value, values being width bytes wide
+    uint8x16_t mask_values(uint8x16_t v, size_t width, uint64_t mask)
+    {
+        switch (width) {
+        case 1:
+            return vandq_u8(v, vdupq_n_u8(static_cast<uint8_t>(mask)));
+        case 2:
+            return vreinterpretq_u8_u16(vandq_u16(
+                    vreinterpretq_u16_u8(v), vdupq_n_u16(static_cast<uint16_t>(mask))));
+        default:
+            return vreinterpretq_u8_u32(vandq_u32(
+                    vreinterpretq_u32_u8(v), vdupq_n_u32(static_cast<uint32_t>(mask))));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Neighbouring values merge into one twice as wide, the first on top
+    uint8x16_t merge_pairs(uint8x16_t v, size_t width, size_t bits)
+    {
+        switch (width) {
+        case 1: {
+            auto lanes = vreinterpretq_u16_u8(v);
+            return vreinterpretq_u8_u16(vorrq_u16(
+                    vshlq_u16(vandq_u16(lanes, vdupq_n_u16(0x00ff)), vdupq_n_s16(static_cast<int16_t>(bits))),
+                    vshrq_n_u16(lanes, 8)));
+        }
+        case 2: {
+            auto lanes = vreinterpretq_u32_u8(v);
+            return vreinterpretq_u8_u32(vorrq_u32(
+                    vshlq_u32(vandq_u32(lanes, vdupq_n_u32(0x0000ffff)), vdupq_n_s32(static_cast<int32_t>(bits))),
+                    vshrq_n_u32(lanes, 16)));
+        }
+        default: {
+            auto lanes = vreinterpretq_u64_u8(v);
+            return vreinterpretq_u8_u64(vorrq_u64(
+                    vshlq_u64(vandq_u64(lanes, vdupq_n_u64(0xffffffffull)), vdupq_n_s64(static_cast<int64_t>(bits))),
+                    vshrq_n_u64(lanes, 32)));
+        }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    // Two words of packed values out of 16 bytes of them
+    void pack_vector(const uint8_t* values, size_t width, size_t bits, uint64_t mask, uint64_t* words)
+    {
+        auto v = mask_values(vld1q_u8(values), width, mask);
+        for (; width < sizeof(uint64_t); width *= 2, bits *= 2) {
+            v = merge_pairs(v, width, bits);
+        }
+        vst1q_u64(words, vreinterpretq_u64_u8(v));
+    }
+#endif
+
+    //--------------------------------------------------------------------------
+    uint64_t load_value(const uint8_t* value, size_t width)
+    {
+        switch (width) {
+        case 1:
+            return *value;
+        case 2: {
+            uint16_t ret;
+            std::memcpy(&ret, value, sizeof(ret));
+            return ret;
+        }
+        default: {
+            uint32_t ret;
+            std::memcpy(&ret, value, sizeof(ret));
+            return ret;
+        }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+const uint8_t* brcpp::find_bytes(
+        const uint8_t* begin,
+        const uint8_t* end,
+        const uint8_t* pattern,
+        size_t size)
+{
+    if (size == 0) {
+        return begin;
+    }
+
+    if (static_cast<size_t>(end - begin) < size) {
+        return end;
+    }
+
+    if (size == 1) {
+        auto found = std::memchr(begin, pattern[0], static_cast<size_t>(end - begin));
+        return found ? static_cast<const uint8_t*>(found) : end;
+    }
+
+    const uint8_t first = pattern[0];
+    const uint8_t last = pattern[size - 1];
+    const uint8_t* current = begin;
+    const uint8_t* const limit = end - size + 1; // last possible match start + 1
+
+#if defined(BRCPP_SCAN_SSE2) || defined(BRCPP_SCAN_NEON)
+    while (static_cast<size_t>(limit - current) >= Lanes) {
+        auto mask = candidates(current, size - 1, first, last);
+        while (mask != 0) {
+            auto lane = static_cast<size_t>(std::countr_zero(mask)) / BitsPerLane;
+            if (std::memcmp(current + lane + 1, pattern + 1, size - 2) == 0) {
+                return current + lane;
+            }
+            mask &= mask - 1;
+        }
+        current += Lanes;
+    }
+#endif
+
+    for (; current < limit; ++current) {
+        if (current[0] == first && current[size - 1] == last &&
+            std::memcmp(current + 1, pattern + 1, size - 2) == 0)
+        {
+            return current;
+        }
+    }
+
+    return end;
+}
+
+//------------------------------------------------------------------------------
+size_t brcpp::pack_bits(
+        const uint8_t* values,
+        size_t count,
+        size_t width,
+        size_t bits,
+        uint64_t* words)
+{
+    if ((width != 1 && width != 2 && width != 4) || bits == 0 || bits > width * 8) {
+        throw std::invalid_argument("Unsupported value or field width");
+    }
+
+    const size_t per_word = sizeof(uint64_t) / width;
+    const size_t total = count / per_word;
+    const uint64_t mask = (uint64_t(1) << bits) - 1;
+    size_t done = 0;
+
+#if defined(BRCPP_SCAN_SSE2) || defined(BRCPP_SCAN_NEON)
+    // A word is 8 bytes of values, so a vector makes two of them
+    if constexpr (std::endian::native == std::endian::little) {
+        for (; done + 2 <= total; done += 2) {
+            pack_vector(values + done * sizeof(uint64_t), width, bits, mask, words + done);
+        }
+    }
+#endif
+
+    for (; done < total; ++done) {
+        const auto current = values + done * sizeof(uint64_t);
+        uint64_t word = 0;
+        for (size_t iter = 0; iter < per_word; ++iter) {
+            word = (word << bits) | (load_value(current + iter * width, width) & mask);
+        }
+        words[done] = word;
+    }
+
+    return total;
+}
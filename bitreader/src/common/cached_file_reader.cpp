@@ -0,0 +1,98 @@
+#include "bitreader/common/cached_file_reader.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+size_t cached_file_reader::read(uint8_t* dest, uint64_t position, size_t bytes)
+{
+    const auto block_size = _cache->block_size();
+    size_t done = 0;
+    while (done < bytes) {
+        auto current = position + done;
+        auto block = _cache->get(_file, current / block_size, *_reader);
+        auto offset = static_cast<size_t>(current % block_size);
+        if (offset >= block.size()) {
+            break;
+        }
+
+        auto to_copy = std::min(block.size() - offset, bytes - done);
+        std::copy(block.begin() + offset, block.begin() + offset + to_copy, dest + done);
+        done += to_copy;
+
+        if (block.size() < block_size) {
+            break;
+        }
+    }
+
+    return done;
+}
+
+//----------------------------------------------------------------------
+uint64_t cached_file_reader::size()
+{
+    return _reader->size();
+}
+
+//----------------------------------------------------------------------
+bool cached_file_reader::depleted()
+{
+    return _reader->depleted();
+}
+
+//----------------------------------------------------------------------
+void cached_file_reader::prefetch(uint64_t position, size_t bytes)
+{
+    _reader->prefetch(position, bytes);
+}
+
+//----------------------------------------------------------------------
+shared_buffer cached_file_reader::borrow(uint64_t position, uint64_t& start)
+{
+    const auto block_size = _cache->block_size();
+    const auto index = position / block_size;
+    auto block = _cache->get(_file, index, *_reader);
+
+    // A fixed view, so that nobody grows the cached block in place
+    start = index * block_size;
+    return block.slice(0, block.size());
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<file_reader> cached_file_reader::clone()
+{
+    auto ret = new cached_file_reader(_reader->clone(), _cache, _file);
+    return std::shared_ptr<file_reader>(ret);
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<file_reader> cached_file_reader::wrap(
+        std::shared_ptr<file_reader> reader,
+        std::shared_ptr<block_cache> cache)
+{
+    if (!reader || !cache) {
+        throw std::invalid_argument("Cached reader needs a reader and a cache");
+    }
+
+    auto alignment = std::max<size_t>(reader->alignment(), 1);
+    if (cache->block_size() % alignment != 0) {
+        throw std::invalid_argument("Cache block size must be a multiple of the reader alignment");
+    }
+
+    auto file = cache->register_file();
+    auto ret = new cached_file_reader(std::move(reader), std::move(cache), file);
+    return std::shared_ptr<file_reader>(ret);
+}
+
+//----------------------------------------------------------------------
+cached_file_reader::cached_file_reader(
+        std::shared_ptr<file_reader> reader,
+        std::shared_ptr<block_cache> cache,
+        uint64_t file)
+    : _reader(std::move(reader))
+    , _cache(std::move(cache))
+    , _file(file)
+{
+
+}
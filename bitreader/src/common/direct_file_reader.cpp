@@ -22,6 +22,8 @@ namespace
     }
 }
 #else
+#include <fcntl.h>
+
 namespace
 {
     int fseek64(FILE* file, uint64_t pos, int origin)
@@ -61,6 +63,21 @@ bool direct_file_reader::depleted() {
     return true;
 }
 
+//----------------------------------------------------------------------
+void direct_file_reader::prefetch(uint64_t position, size_t bytes) {
+#if defined(POSIX_FADV_WILLNEED)
+    // Kicks off asynchronous readahead into the page cache
+    posix_fadvise(
+            fileno(_file),
+            static_cast<off_t>(position),
+            static_cast<off_t>(bytes),
+            POSIX_FADV_WILLNEED);
+#else
+    (void)position;
+    (void)bytes;
+#endif
+}
+
 //----------------------------------------------------------------------
 direct_file_reader::~direct_file_reader() {
     fclose(_file);
@@ -0,0 +1,119 @@
+#include "bitreader/common/huge_page_resource.hpp"
+#include <new>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    size_t round_to_pages(size_t bytes)
+    {
+        const size_t page = huge_page_resource::HugePageSize;
+        return (bytes + page - 1) & ~(page - 1);
+    }
+
+#ifndef WIN32
+    //--------------------------------------------------------------------------
+    void* map_huge(size_t size)
+    {
+#ifdef MAP_HUGETLB
+        // Explicit huge pages only work if the administrator reserved some
+        void* explicit_huge = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (explicit_huge != MAP_FAILED) {
+            return explicit_huge;
+        }
+#endif
+
+        // Transparent huge pages need a suitably aligned region, so map
+        // one page extra and trim the ends
+        const size_t page = huge_page_resource::HugePageSize;
+        void* raw = ::mmap(nullptr, size + page, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+
+        auto start = reinterpret_cast<uintptr_t>(raw);
+        auto aligned = (start + page - 1) & ~static_cast<uintptr_t>(page - 1);
+        auto head = static_cast<size_t>(aligned - start);
+        if (head > 0) {
+            ::munmap(raw, head);
+        }
+        ::munmap(reinterpret_cast<void*>(aligned + size), page - head);
+
+        auto ret = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+        ::madvise(ret, size, MADV_HUGEPAGE);
+#endif
+        return ret;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+huge_page_resource::huge_page_resource(
+        size_t threshold,
+        std::pmr::memory_resource* upstream)
+    : _threshold(threshold)
+    , _upstream(upstream)
+{
+
+}
+
+//----------------------------------------------------------------------
+bool huge_page_resource::is_mapped(size_t bytes, size_t alignment) const
+{
+#ifdef WIN32
+    // Large pages need a special privilege there, leave it to upstream
+    (void)bytes;
+    (void)alignment;
+    return false;
+#else
+    return bytes >= _threshold && alignment <= HugePageSize;
+#endif
+}
+
+//----------------------------------------------------------------------
+void* huge_page_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    if (!is_mapped(bytes, alignment)) {
+        return _upstream->allocate(bytes, alignment);
+    }
+
+#ifndef WIN32
+    const auto size = round_to_pages(bytes);
+    auto ret = map_huge(size);
+    _mapped.fetch_add(1, std::memory_order_relaxed);
+    _mapped_bytes.fetch_add(size, std::memory_order_relaxed);
+    return ret;
+#else
+    return nullptr;
+#endif
+}
+
+//----------------------------------------------------------------------
+void huge_page_resource::do_deallocate(void* ptr, size_t bytes, size_t alignment)
+{
+    if (!is_mapped(bytes, alignment)) {
+        _upstream->deallocate(ptr, bytes, alignment);
+        return;
+    }
+
+#ifndef WIN32
+    const auto size = round_to_pages(bytes);
+    ::munmap(ptr, size);
+    _mapped.fetch_sub(1, std::memory_order_relaxed);
+    _mapped_bytes.fetch_sub(size, std::memory_order_relaxed);
+#endif
+}
+
+//----------------------------------------------------------------------
+bool huge_page_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
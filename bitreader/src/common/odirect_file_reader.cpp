@@ -0,0 +1,204 @@
+#include "bitreader/common/odirect_file_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace brcpp;
+
+namespace
+{
+    constexpr const size_t BounceBufferSize = 256 * 1024;
+    constexpr const size_t MaxPooledBuffers = 4;
+
+    //--------------------------------------------------------------------------
+    int open_unbuffered(const std::string& path)
+    {
+#ifdef O_DIRECT
+        return ::open(path.c_str(), O_RDONLY | O_DIRECT);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+#ifdef F_NOCACHE
+        if (fd >= 0 && fcntl(fd, F_NOCACHE, 1) < 0) {
+            ::close(fd);
+            return -1;
+        }
+#endif
+        return fd;
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    // Hands a bounce buffer back to its pool however the read ends
+    class pooled_buffer
+    {
+    public:
+        explicit pooled_buffer(buffer_pool& pool)
+            : _pool(pool)
+            , _buffer(pool.acquire())
+        {}
+
+        pooled_buffer(const pooled_buffer&) = delete;
+        pooled_buffer& operator=(const pooled_buffer&) = delete;
+
+        ~pooled_buffer()
+        {
+            _pool.release(std::move(_buffer));
+        }
+
+        shared_buffer* operator->() { return &_buffer; }
+
+    private:
+        buffer_pool& _pool;
+        shared_buffer _buffer;
+    };
+
+    //--------------------------------------------------------------------------
+    bool is_aligned(uint64_t value, size_t alignment)
+    {
+        return (value & (alignment - 1)) == 0;
+    }
+}
+
+//----------------------------------------------------------------------
+size_t odirect_file_reader::read(uint8_t* dest, uint64_t position, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (is_aligned(reinterpret_cast<uintptr_t>(dest), _alignment) &&
+        is_aligned(position, _alignment) &&
+        is_aligned(bytes, _alignment))
+    {
+        return read_aligned(dest, position, bytes);
+    }
+
+    pooled_buffer bounce(*_pool);
+    size_t done = 0;
+    while (done < bytes) {
+        uint64_t current = position + done;
+        uint64_t block_start = current & ~static_cast<uint64_t>(_alignment - 1);
+        auto head = static_cast<size_t>(current - block_start);
+        size_t wanted = std::min(bytes - done + head, bounce->capacity());
+        wanted = (wanted + _alignment - 1) & ~(_alignment - 1);
+
+        size_t got = read_aligned(bounce->get(), block_start, wanted);
+        if (got <= head) {
+            break;
+        }
+
+        size_t useful = std::min(got - head, bytes - done);
+        std::memcpy(dest + done, bounce->get() + head, useful);
+        done += useful;
+
+        if (got < wanted) {
+            break;
+        }
+    }
+
+    return done;
+}
+
+//----------------------------------------------------------------------
+size_t odirect_file_reader::read_aligned(uint8_t* dest, uint64_t position, size_t bytes)
+{
+    size_t done = 0;
+    while (done < bytes) {
+        auto result = ::pread(
+                _fd,
+                dest + done,
+                bytes - done,
+                static_cast<off_t>(position + done));
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Could not read from file");
+        } else if (result == 0) {
+            break;
+        }
+
+        done += static_cast<size_t>(result);
+        if (!is_aligned(done, _alignment)) {
+            // Short unaligned read only happens at the end of the file
+            break;
+        }
+    }
+
+    return done;
+}
+
+//----------------------------------------------------------------------
+uint64_t odirect_file_reader::size()
+{
+    struct stat info{};
+    if (fstat(_fd, &info) < 0) {
+        throw std::runtime_error("Could not query file size");
+    }
+
+    return static_cast<uint64_t>(info.st_size);
+}
+
+//----------------------------------------------------------------------
+bool odirect_file_reader::depleted()
+{
+    return true;
+}
+
+//----------------------------------------------------------------------
+size_t odirect_file_reader::alignment()
+{
+    return _alignment;
+}
+
+//----------------------------------------------------------------------
+odirect_file_reader::~odirect_file_reader()
+{
+    ::close(_fd);
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<file_reader> odirect_file_reader::open(
+        const std::string& path,
+        size_t alignment)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument("Alignment must be a power of two");
+    }
+
+    auto pool = std::make_shared<buffer_pool>(
+            std::max(BounceBufferSize, alignment),
+            alignment,
+            MaxPooledBuffers);
+
+    return std::shared_ptr<file_reader>(
+            new odirect_file_reader(path, alignment, std::move(pool)));
+}
+
+//----------------------------------------------------------------------
+odirect_file_reader::odirect_file_reader(
+        const std::string& path,
+        size_t alignment,
+        std::shared_ptr<buffer_pool> pool)
+    : _path(path)
+    , _alignment(alignment)
+    , _pool(std::move(pool))
+{
+    _fd = open_unbuffered(path);
+    if (_fd < 0) {
+        throw std::runtime_error("Could not open file for unbuffered reading");
+    }
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<file_reader> odirect_file_reader::clone()
+{
+    auto ret = new odirect_file_reader(_path, _alignment, _pool);
+    return std::shared_ptr<file_reader>(ret);
+}
@@ -1,54 +1,167 @@
 #include "bitreader/common/shared_buffer.hpp"
+#include <new>
+#include <stdexcept>
+#include <utility>
 
 using namespace brcpp;
 
+namespace
+{
+    //--------------------------------------------------------------------------
+    constexpr size_t round_up(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
 //----------------------------------------------------------------------
 shared_buffer::shared_buffer()
-        : _state(make_internal(_internal{}))
+        : _state(empty_header())
+{
+
+}
+
+//----------------------------------------------------------------------
+shared_buffer::shared_buffer(_header* state)
+        : _state(state)
+        , _resource(state->resource)
+        , _alignment(state->alignment)
 {
 
 }
 
+//----------------------------------------------------------------------
+shared_buffer::shared_buffer(const shared_buffer& other)
+        : _state(other._state)
+        , _offset(other._offset)
+        , _length(other._length)
+        , _slice(other._slice)
+        , _growth(other._growth)
+        , _resource(other._resource)
+        , _alignment(other._alignment)
+{
+    acquire();
+}
+
+//----------------------------------------------------------------------
+shared_buffer::shared_buffer(shared_buffer&& other) noexcept
+        : _state(std::exchange(other._state, empty_header()))
+        , _offset(std::exchange(other._offset, 0))
+        , _length(std::exchange(other._length, 0))
+        , _slice(std::exchange(other._slice, false))
+        , _growth(other._growth)
+        , _resource(other._resource)
+        , _alignment(other._alignment)
+{
+
+}
+
+//----------------------------------------------------------------------
+shared_buffer& shared_buffer::operator=(const shared_buffer& other)
+{
+    if (this != &other) {
+        other.acquire();
+        release(_state);
+        _state = other._state;
+        _offset = other._offset;
+        _length = other._length;
+        _slice = other._slice;
+        _growth = other._growth;
+        _resource = other._resource;
+        _alignment = other._alignment;
+    }
+
+    return *this;
+}
+
+//----------------------------------------------------------------------
+shared_buffer& shared_buffer::operator=(shared_buffer&& other) noexcept
+{
+    if (this != &other) {
+        release(_state);
+        _state = std::exchange(other._state, empty_header());
+        _offset = std::exchange(other._offset, 0);
+        _length = std::exchange(other._length, 0);
+        _slice = std::exchange(other._slice, false);
+        _growth = other._growth;
+        _resource = other._resource;
+        _alignment = other._alignment;
+    }
+
+    return *this;
+}
+
+//----------------------------------------------------------------------
+shared_buffer::~shared_buffer()
+{
+    release(_state);
+}
+
+//----------------------------------------------------------------------
+size_t shared_buffer::alignment() const
+{
+    const auto alignment = _alignment;
+    if (_slice && alignment != 0 && _offset % alignment != 0) {
+        return 0;
+    }
+
+    return alignment;
+}
+
 //----------------------------------------------------------------------
 shared_buffer shared_buffer::wrap_mem(uint8_t* data, size_t size)
 {
-    return shared_buffer(make_internal(data, size, size));
+    return shared_buffer(wrap_header(data, size));
 }
 
 //----------------------------------------------------------------------
-shared_buffer shared_buffer::copy_mem(const uint8_t* data, size_t size)
+shared_buffer shared_buffer::copy_mem(
+        const uint8_t* data,
+        size_t size,
+        std::pmr::memory_resource* resource)
 {
-    auto data_copy = new uint8_t[size];
-    std::copy(data, data+size, data_copy);
-    return shared_buffer(make_internal(data_copy, size, size));
+    shared_buffer ret(make_header(size, 0, resource));
+    if (size > 0) {
+        std::copy(data, data+size, ret.get());
+        ret._state->size = size;
+    }
+
+    return ret;
 }
 
 //----------------------------------------------------------------------
 shared_buffer shared_buffer::clone(const shared_buffer& buffer)
 {
     if (!buffer.get()) {
-        return shared_buffer(_internal{});
+        return shared_buffer();
     }
 
+    shared_buffer ret(make_header(buffer.capacity(), buffer.alignment(), buffer.resource()));
+    if (buffer.size() > 0) {
+        std::copy(buffer.cbegin(), buffer.cend(), ret.get());
+        ret._state->size = buffer.size();
+    }
 
-    auto state = make_internal(
-            new uint8_t[buffer.capacity()],
-            buffer.size(),
-            buffer.capacity()
-    );
-
-    std::copy(buffer.get(), buffer.get()+buffer.size(), state->data);
-    return shared_buffer(state);
+    return ret;
 }
 
 //----------------------------------------------------------------------
 shared_buffer shared_buffer::allocate(size_t size)
 {
-    if (size == 0) {
-        return shared_buffer();
-    } else {
-        return shared_buffer(make_internal(new uint8_t[size], 0, size));
+    return shared_buffer(make_header(size, 0, nullptr));
+}
+
+//----------------------------------------------------------------------
+shared_buffer shared_buffer::allocate(
+        size_t size,
+        size_t alignment,
+        std::pmr::memory_resource* resource)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument("Buffer alignment must be a power of two");
     }
+
+    return shared_buffer(make_header(size, alignment, resource));
 }
 
 //----------------------------------------------------------------------
@@ -56,17 +169,19 @@ void shared_buffer::realloc(size_t new_size)
 {
     if (new_size == capacity()) {
         return;
-    } else if (new_size == 0) {
-        _state = make_internal(_internal{});
-    } else {
-        auto new_data = new uint8_t[new_size];
-        auto copy_size = std::min(size(), new_size);
-        if (copy_size > 0) {
-            std::copy(begin(), begin()+copy_size, new_data);
-        }
+    }
 
-        _state = make_internal(new_data, copy_size, new_size);
+    shared_buffer replacement(make_header(new_size, alignment(), resource()));
+    auto copy_size = std::min(size(), new_size);
+    if (copy_size > 0) {
+        std::copy(begin(), begin()+copy_size, replacement.get());
+        replacement._state->size = copy_size;
     }
+
+    replacement._growth = _growth;
+    replacement._resource = _resource;
+    replacement._alignment = alignment();
+    *this = std::move(replacement);
 }
 
 //----------------------------------------------------------------------
@@ -75,16 +190,72 @@ void shared_buffer::resize(size_t new_size)
     if (new_size == size()) {
         return;
     } else if (new_size <= capacity()) {
-        _state->size = new_size;
-    } else {
-        auto new_data = new uint8_t[new_size];
-        auto copy_size = std::min(new_size, size());
-        if (copy_size > 0) {
-            std::copy(begin(), begin()+copy_size, new_data);
+        if (_slice) {
+            _length = new_size;
+        } else {
+            _state->size = new_size;
         }
+    } else {
+        auto grown = static_cast<size_t>(static_cast<double>(capacity()) * _growth);
+        grow(std::max(new_size, grown), new_size);
+    }
+}
+
+//----------------------------------------------------------------------
+void shared_buffer::reserve(size_t capacity)
+{
+    if (capacity > this->capacity()) {
+        grow(capacity, size());
+    }
+}
+
+//----------------------------------------------------------------------
+void shared_buffer::grow(size_t capacity, size_t new_size)
+{
+    shared_buffer replacement(make_header(capacity, alignment(), resource()));
+    auto copy_size = std::min(new_size, size());
+    if (copy_size > 0) {
+        std::copy(begin(), begin()+copy_size, replacement.get());
+    }
+
+    replacement._state->size = new_size;
+    replacement._growth = _growth;
+    *this = std::move(replacement);
+}
+
+//----------------------------------------------------------------------
+shared_buffer::storage shared_buffer::take()
+{
+    if (_state == empty_header()) {
+        return storage();
+    }
 
-        _state = make_internal(new_data, new_size, new_size);
+    if (use_count() != 1) {
+        throw std::runtime_error("Cannot take data shared with other buffers");
     }
+
+    storage ret(get(), storage_deleter(_state));
+    _state = empty_header();
+    _offset = 0;
+    _length = 0;
+    _slice = false;
+    return ret;
+}
+
+//----------------------------------------------------------------------
+void shared_buffer::set_growth_factor(double factor)
+{
+    if (!(factor >= 1.0)) {
+        throw std::invalid_argument("Growth factor must be at least 1");
+    }
+
+    _growth = factor;
+}
+
+//----------------------------------------------------------------------
+void shared_buffer::storage_deleter::operator()(uint8_t*) const
+{
+    shared_buffer::release(_state);
 }
 
 //----------------------------------------------------------------------
@@ -94,46 +265,137 @@ shared_buffer::operator bool() const
 }
 
 //----------------------------------------------------------------------
-std::shared_ptr<shared_buffer::_internal> shared_buffer::make_internal(
-        _internal state)
+shared_buffer shared_buffer::slice(size_t offset, size_t length) const
 {
-    std::shared_ptr<_internal> ret(
-            new _internal(state),
-            [](_internal* ptr) {
-                delete[] ptr->data;
-                ptr->size = 0;
-                ptr->capacity = 0;
-                delete ptr;
-            }
-    );
+    if (offset > size() || length > size() - offset) {
+        throw std::out_of_range("Slice exceeds the buffer size");
+    }
 
+    shared_buffer ret(*this);
+    ret._offset = _offset + offset;
+    ret._length = length;
+    ret._slice = true;
     return ret;
 }
 
 //----------------------------------------------------------------------
-std::shared_ptr<shared_buffer::_internal> shared_buffer::make_internal(
-        uint8_t* data,
-        size_t size,
-        size_t capacity)
+size_t shared_buffer::use_count() const
 {
-    _internal state;
-    state.data = data;
-    state.size = size;
-    state.capacity = capacity;
-    return make_internal(state);
+    if (_state == empty_header()) {
+        return 0;
+    }
+
+    return _state->refs.load(std::memory_order_acquire);
 }
 
 //----------------------------------------------------------------------
-shared_buffer::shared_buffer(_internal state)
-        : _state(make_internal(state))
+void shared_buffer::acquire() const
 {
+    if (_state != empty_header()) {
+        _state->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
+//----------------------------------------------------------------------
+void shared_buffer::release(_header* state)
+{
+    if (state == empty_header() ||
+        state->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (state->external) {
+        delete[] state->data;
+        delete state;
+    } else if (state->separate) {
+        state->resource->deallocate(state->data, state->block_size, state->block_alignment);
+        delete state;
+    } else {
+        // The header sits right after the data, in the same block
+        void* block = state->data;
+        auto resource = state->resource;
+        auto block_size = state->block_size;
+        auto block_alignment = state->block_alignment;
+        state->~_header();
+        resource->deallocate(block, block_size, block_alignment);
+    }
 }
 
 //----------------------------------------------------------------------
-shared_buffer::shared_buffer(std::shared_ptr<_internal> state)
-        : _state(std::move(state))
+shared_buffer::_header* shared_buffer::make_header(
+        size_t capacity,
+        size_t alignment,
+        std::pmr::memory_resource* resource)
 {
+    if (capacity == 0) {
+        return empty_header();
+    }
+
+    if (!resource) {
+        resource = std::pmr::get_default_resource();
+    }
+
+    if (resource != std::pmr::get_default_resource()) {
+        // A resource picked for the data gets exactly the requested size
+        // (e.g. whole huge pages), the header is allocated on its own
+        const size_t block_alignment = std::max(
+                alignment,
+                size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+        auto data = static_cast<uint8_t*>(resource->allocate(capacity, block_alignment));
+
+        _header* state;
+        try {
+            state = new _header;
+        } catch (...) {
+            resource->deallocate(data, capacity, block_alignment);
+            throw;
+        }
+
+        state->data = data;
+        state->capacity = capacity;
+        state->alignment = alignment;
+        state->block_alignment = block_alignment;
+        state->block_size = capacity;
+        state->resource = resource;
+        state->separate = true;
+        return state;
+    }
+
+    // Data first, so that its alignment costs no padding
+    const size_t block_alignment = std::max({
+            alignment,
+            alignof(_header),
+            size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__)});
+    const size_t header_offset = round_up(capacity, alignof(_header));
+    const size_t block_size = header_offset + sizeof(_header);
+
+    auto block = static_cast<uint8_t*>(resource->allocate(block_size, block_alignment));
 
+    auto state = new (block + header_offset) _header;
+    state->data = block;
+    state->capacity = capacity;
+    state->alignment = alignment;
+    state->block_alignment = block_alignment;
+    state->block_size = block_size;
+    state->resource = resource;
+    return state;
 }
 
+//----------------------------------------------------------------------
+shared_buffer::_header* shared_buffer::wrap_header(uint8_t* data, size_t size)
+{
+    auto state = new _header;
+    state->data = data;
+    state->capacity = size;
+    state->size = size;
+    state->external = true;
+    return state;
+}
+
+//----------------------------------------------------------------------
+shared_buffer::_header* shared_buffer::empty_header()
+{
+    // Shared by all empty buffers, never counted or released
+    static _header empty;
+    return &empty;
+}
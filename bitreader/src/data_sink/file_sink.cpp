@@ -0,0 +1,325 @@
+#include "bitreader/data_sink/file_sink.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace brcpp;
+
+namespace
+{
+    // Lets a window run past the block size instead of cutting a block short
+    constexpr const size_t WindowSlack = 64;
+
+    //--------------------------------------------------------------------------
+    int write_all(int fd, const uint8_t* data, size_t size, uint64_t offset)
+    {
+        size_t done = 0;
+        while (done < size) {
+            auto result = ::pwrite(
+                    fd,
+                    data + done,
+                    size - done,
+                    static_cast<off_t>(offset + done));
+
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+
+            done += static_cast<size_t>(result);
+        }
+
+        return 0;
+    }
+
+    //--------------------------------------------------------------------------
+    int sync_data(int fd)
+    {
+#ifdef __APPLE__
+        return ::fsync(fd);
+#else
+        return ::fdatasync(fd);
+#endif
+    }
+}
+
+//----------------------------------------------------------------------
+file_sink::file_sink(
+        const std::string& path,
+        sync_policy sync,
+        size_t block_size,
+        size_t queue_depth)
+    : _block_size(block_size)
+    , _queue_depth(std::max<size_t>(queue_depth, 1))
+    , _sync(sync)
+    , _slots(static_cast<std::ptrdiff_t>(_queue_depth))
+{
+    if (block_size == 0) {
+        throw std::invalid_argument("Block size must not be zero");
+    }
+
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        throw std::runtime_error("Could not open file for writing");
+    }
+
+    try {
+        // Blocks in the queue, the one being written and the one being filled
+        _pool = std::make_shared<buffer_pool>(
+                block_size + WindowSlack,
+                BlockAlignment,
+                _queue_depth + 2);
+
+        _thread = std::thread([this] { writer(); });
+    } catch (...) {
+        // The destructor does not run when the constructor throws
+        ::close(_fd);
+        throw;
+    }
+}
+
+//----------------------------------------------------------------------
+file_sink::~file_sink()
+{
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+//----------------------------------------------------------------------
+void file_sink::write_at(uint64_t position, const uint8_t* data, size_t size)
+{
+    patch(position, data, nullptr, size);
+}
+
+//----------------------------------------------------------------------
+void file_sink::merge_at(
+        uint64_t position,
+        const uint8_t* data,
+        const uint8_t* mask,
+        size_t size)
+{
+    patch(position, data, mask, size);
+}
+
+//----------------------------------------------------------------------
+void file_sink::patch(
+        uint64_t position,
+        const uint8_t* data,
+        const uint8_t* mask,
+        size_t size)
+{
+    if (position > this->position() || size > this->position() - position) {
+        throw std::range_error("Cannot write beyond the output");
+    }
+
+    // The part still in the current block is simply changed there
+    if (position + size > _block_offset) {
+        auto start = std::max(position, _block_offset);
+        auto skip = static_cast<size_t>(start - position);
+        auto dest = _block.get() + (start - _block_offset);
+        if (mask) {
+            merge_bytes(dest, data + skip, mask + skip, size - skip);
+        } else {
+            std::memcpy(dest, data + skip, size - skip);
+        }
+        size = skip;
+    }
+
+    if (size > 0) {
+        job item{position, shared_buffer::copy_mem(data, size)};
+        if (mask) {
+            item.mask = shared_buffer::copy_mem(mask, size);
+        }
+        submit(std::move(item));
+    }
+}
+
+//----------------------------------------------------------------------
+void file_sink::flush()
+{
+    submit_block();
+    check_error();
+}
+
+//----------------------------------------------------------------------
+void file_sink::sync()
+{
+    flush();
+    drain();
+    if (::fsync(_fd) < 0) {
+        throw std::runtime_error("Could not sync file");
+    }
+}
+
+//----------------------------------------------------------------------
+void file_sink::close()
+{
+    if (_fd < 0) {
+        return;
+    }
+
+    // The writer has to be stopped and the file closed no matter what
+    std::exception_ptr failure;
+    try {
+        submit_block();
+    } catch (...) {
+        failure = std::current_exception();
+    }
+
+    // One wake-up more than there are jobs tells the writer to stop
+    _items.release();
+    _thread.join();
+
+    int error = _error.load();
+    if (error == 0 && _sync != sync_policy::none && ::fsync(_fd) < 0) {
+        error = errno;
+    }
+
+    ::close(_fd);
+    _fd = -1;
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    } else if (error != 0) {
+        throw std::runtime_error(std::string("Could not write file: ") + std::strerror(error));
+    }
+}
+
+//----------------------------------------------------------------------
+void file_sink::next_block(size_t bytes)
+{
+    if (_fd < 0) {
+        throw std::runtime_error("Cannot write to a closed file");
+    }
+
+    submit_block();
+    _block = _pool->acquire(std::max(bytes, _pool->buffer_size()));
+}
+
+//----------------------------------------------------------------------
+void file_sink::submit_block()
+{
+    if (_block.size() == 0) {
+        return;
+    }
+
+    auto offset = _block_offset;
+    _block_offset += _block.size();
+    submit(job{offset, std::exchange(_block, shared_buffer())});
+}
+
+//----------------------------------------------------------------------
+void file_sink::submit(job&& item)
+{
+    if (_fd < 0) {
+        throw std::runtime_error("Cannot write to a closed file");
+    }
+
+    check_error();
+    _slots.acquire();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _queue.push_back(std::move(item));
+    }
+    _pending.fetch_add(1);
+    _items.release();
+}
+
+//----------------------------------------------------------------------
+void file_sink::drain()
+{
+    auto pending = _pending.load();
+    while (pending != 0) {
+        _pending.wait(pending);
+        pending = _pending.load();
+    }
+
+    check_error();
+}
+
+//----------------------------------------------------------------------
+void file_sink::check_error()
+{
+    if (int error = _error.load(); error != 0) {
+        throw std::runtime_error(std::string("Could not write file: ") + std::strerror(error));
+    }
+}
+
+//----------------------------------------------------------------------
+int file_sink::merge_all(int fd, job& item)
+{
+    // Blocks are written in order, so the bytes are in the file already
+    auto current = shared_buffer::allocate(item.data.size());
+    current.resize(item.data.size());
+    size_t done = 0;
+    while (done < current.size()) {
+        auto result = ::pread(
+                fd,
+                current.get() + done,
+                current.size() - done,
+                static_cast<off_t>(item.offset + done));
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        } else if (result == 0) {
+            return EIO;
+        }
+
+        done += static_cast<size_t>(result);
+    }
+
+    merge_bytes(current.get(), item.data.get(), item.mask.get(), current.size());
+    item.data = std::move(current);
+    return 0;
+}
+
+//----------------------------------------------------------------------
+void file_sink::writer()
+{
+    for (;;) {
+        _items.acquire();
+
+        job item;
+        {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_queue.empty()) {
+                // Woken up by close() with nothing left to write
+                return;
+            }
+
+            item = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        // Once a write has failed the rest is only dropped
+        if (_error.load() == 0) {
+            int error = item.mask ? merge_all(_fd, item) : 0;
+            if (error == 0) {
+                error = write_all(_fd, item.data.get(), item.data.size(), item.offset);
+            }
+            if (error == 0 && _sync == sync_policy::every_block && sync_data(_fd) < 0) {
+                error = errno;
+            }
+
+            int expected = 0;
+            _error.compare_exchange_strong(expected, error);
+        }
+        _pool->release(std::move(item.data));
+
+        _slots.release();
+        _pending.fetch_sub(1);
+        _pending.notify_all();
+    }
+}
@@ -0,0 +1,66 @@
+#include "bitreader/data_sink/memory_sink.hpp"
+#include <algorithm>
+#include <utility>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+memory_sink::memory_sink(size_t capacity, std::pmr::memory_resource* resource)
+        : _initial(std::max<size_t>(capacity, 1))
+        , _resource(resource)
+{
+
+}
+
+//----------------------------------------------------------------------
+void memory_sink::write_at(uint64_t position, const uint8_t* data, size_t size)
+{
+    if (position > _buffer.size() || size > _buffer.size() - position) {
+        throw std::range_error("Cannot write beyond the output");
+    }
+
+    std::copy(data, data + size, _buffer.get() + position);
+}
+
+//----------------------------------------------------------------------
+void memory_sink::merge_at(
+        uint64_t position,
+        const uint8_t* data,
+        const uint8_t* mask,
+        size_t size)
+{
+    if (position > _buffer.size() || size > _buffer.size() - position) {
+        throw std::range_error("Cannot write beyond the output");
+    }
+
+    merge_bytes(_buffer.get() + position, data, mask, size);
+}
+
+//----------------------------------------------------------------------
+void memory_sink::reserve(size_t capacity)
+{
+    if (!_buffer) {
+        _buffer = shared_buffer::allocate(std::max(capacity, _initial), BufferAlignment, _resource);
+    } else {
+        _buffer.reserve(capacity);
+    }
+}
+
+//----------------------------------------------------------------------
+void memory_sink::grow(size_t bytes)
+{
+    const auto size = _buffer.size();
+    if (!_buffer) {
+        reserve(bytes);
+    } else {
+        // Let the buffer pick the new capacity by its growth policy
+        _buffer.resize(size + bytes);
+        _buffer.resize(size);
+    }
+}
+
+//----------------------------------------------------------------------
+shared_buffer memory_sink::finish()
+{
+    return std::exchange(_buffer, shared_buffer());
+}
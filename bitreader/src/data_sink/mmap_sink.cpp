@@ -0,0 +1,143 @@
+#include "bitreader/data_sink/mmap_sink.hpp"
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+mmap_sink::mmap_sink(const std::string& path, size_t capacity)
+    : _page_size(static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+{
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0) {
+        throw std::runtime_error("Could not open file for writing");
+    }
+
+    try {
+        remap(capacity);
+    } catch (...) {
+        ::close(_fd);
+        throw;
+    }
+}
+
+//----------------------------------------------------------------------
+mmap_sink::~mmap_sink()
+{
+    try {
+        close();
+    } catch (const std::exception&) {
+    }
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::write_at(uint64_t position, const uint8_t* data, size_t size)
+{
+    if (_fd < 0) {
+        throw std::runtime_error("Cannot write to a closed file");
+    } else if (position > _size || size > _size - position) {
+        throw std::range_error("Cannot write beyond the output");
+    }
+
+    std::memcpy(_data + position, data, size);
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::merge_at(
+        uint64_t position,
+        const uint8_t* data,
+        const uint8_t* mask,
+        size_t size)
+{
+    if (_fd < 0) {
+        throw std::runtime_error("Cannot write to a closed file");
+    } else if (position > _size || size > _size - position) {
+        throw std::range_error("Cannot write beyond the output");
+    }
+
+    merge_bytes(_data + position, data, mask, size);
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::reserve(size_t capacity)
+{
+    if (capacity > _capacity) {
+        remap(capacity);
+    }
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::sync()
+{
+    if (_data && ::msync(_data, _capacity, MS_SYNC) < 0) {
+        throw std::runtime_error("Could not sync mapped file");
+    }
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::close()
+{
+    if (_fd < 0) {
+        return;
+    }
+
+    if (_data) {
+        ::munmap(_data, _capacity);
+        _data = nullptr;
+    }
+
+    const bool truncated = ::ftruncate(_fd, static_cast<off_t>(_size)) == 0;
+    ::close(_fd);
+    _fd = -1;
+    _capacity = _size;  // no room left, writes go to grow() and fail there
+
+    if (!truncated) {
+        throw std::runtime_error("Could not set the output file size");
+    }
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::grow(size_t bytes)
+{
+    if (_fd < 0) {
+        throw std::runtime_error("Cannot write to a closed file");
+    }
+
+    remap(std::max(_size + bytes, _capacity * 2));
+}
+
+//----------------------------------------------------------------------
+void mmap_sink::remap(size_t capacity)
+{
+    capacity = std::max(capacity, _page_size);
+    capacity = (capacity + _page_size - 1) & ~(_page_size - 1);
+
+    if (::ftruncate(_fd, static_cast<off_t>(capacity)) < 0) {
+        throw std::runtime_error("Could not extend the output file");
+    }
+
+    void* mapped;
+#ifdef MREMAP_MAYMOVE
+    if (_data) {
+        mapped = ::mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+    } else {
+        mapped = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+#else
+    mapped = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (mapped != MAP_FAILED && _data) {
+        ::munmap(_data, _capacity);
+    }
+#endif
+
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Could not map the output file");
+    }
+
+    _data = static_cast<uint8_t*>(mapped);
+    _capacity = capacity;
+}
@@ -0,0 +1,158 @@
+#include "bitreader/data_source/bit_memory_byte_source.hpp"
+#include <stdexcept>
+
+#include "bitreader/common/numeric.hpp"
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+bit_memory_byte_source::bit_memory_byte_source()
+        : _begin(nullptr), _end(nullptr), _shift(0)
+        , _bit_size(0), _size(0), _position(0)
+{
+
+}
+
+//----------------------------------------------------------------------
+bit_memory_byte_source::bit_memory_byte_source(
+        const uint8_t* data,
+        uint64_t bit_offset,
+        uint64_t bit_size)
+        : bit_memory_byte_source(
+                shared_buffer::copy_mem(
+                        data + bit_offset / 8,
+                        static_cast<size_t>((bit_offset % 8 + bit_size + 7) / 8)),
+                bit_offset % 8,
+                bit_size)
+{
+
+}
+
+//----------------------------------------------------------------------
+bit_memory_byte_source::bit_memory_byte_source(
+        borrow_memory_t,
+        const uint8_t* data,
+        uint64_t bit_offset,
+        uint64_t bit_size)
+        : _begin(data + bit_offset / 8)
+        , _end(data + (bit_offset + bit_size + 7) / 8)
+        , _shift(static_cast<unsigned>(bit_offset % 8))
+        , _bit_size(bit_size)
+        , _size((bit_size + 7) / 8)
+        , _position(0)
+{
+
+}
+
+//----------------------------------------------------------------------
+bit_memory_byte_source::bit_memory_byte_source(
+        shared_buffer data,
+        uint64_t bit_offset,
+        uint64_t bit_size)
+        : bit_memory_byte_source(borrow_memory, data.cbegin(), bit_offset, bit_size)
+{
+    if (bit_offset + bit_size > uint64_t(data.size()) * 8) {
+        throw std::invalid_argument("Bit range exceeds the buffer");
+    }
+
+    _data = std::move(data);
+}
+
+//----------------------------------------------------------------------
+size_t bit_memory_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (_position == _size) {
+        throw std::runtime_error("Access beyond data buffer boundaries");
+    }
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+    const uint8_t* current = _begin + _position;
+
+    // Fast path: one unaligned 64-bit load plus the bits of the ninth
+    // byte, as long as all of it is in range and the partial last byte
+    // (which needs masking) is not involved
+    if (_position + to_shift < _size && current + 9 <= _end) {
+        uint64_t word = load_be64(current);
+        if (_shift != 0) {
+            word = (word << _shift) | static_cast<uint64_t>(current[8] >> (8 - _shift));
+        }
+
+        if (to_shift == 8) {
+            buf = word;
+        } else {
+            buf = (buf << (8 * to_shift)) | (word >> (64 - 8 * to_shift));
+        }
+    } else {
+        for (size_t iter = 0; iter < to_shift; ++iter) {
+            buf = (buf << 8) | byte_at(_position + iter);
+        }
+    }
+
+    _position += to_shift;
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+uint8_t bit_memory_byte_source::byte_at(uint64_t position) const
+{
+    const uint8_t* current = _begin + position;
+    unsigned value = static_cast<unsigned>(*current) << _shift;
+    if (_shift != 0 && current + 1 < _end) {
+        value |= static_cast<unsigned>(current[1] >> (8 - _shift));
+    }
+
+    // Zero the bits past the end of the range
+    if (position + 1 == _size && _bit_size % 8 != 0) {
+        value &= 0xFFu << (8 - _bit_size % 8);
+    }
+
+    return static_cast<uint8_t>(value);
+}
+
+//----------------------------------------------------------------------
+bool bit_memory_byte_source::depleted()
+{
+    return true;
+}
+
+//----------------------------------------------------------------------
+uint64_t bit_memory_byte_source::available()
+{
+    return _size - _position;
+}
+
+//----------------------------------------------------------------------
+uint64_t bit_memory_byte_source::position()
+{
+    return _position;
+}
+
+//----------------------------------------------------------------------
+void bit_memory_byte_source::seek(uint64_t position)
+{
+    if (position > _size) {
+        throw std::range_error("Position outside of the data buffer");
+    }
+
+    _position = position;
+}
+
+//----------------------------------------------------------------------
+void bit_memory_byte_source::skip(uint64_t bytes)
+{
+    if (bytes > available()) {
+        throw std::range_error("Cannot skip beyond the boundaries of the data buffer");
+    }
+
+    _position += bytes;
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<bit_memory_byte_source> bit_memory_byte_source::clone()
+{
+    return std::make_shared<bit_memory_byte_source>(*this);
+}
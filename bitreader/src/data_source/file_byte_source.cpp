@@ -1,16 +1,108 @@
 #include "bitreader/data_source/file_byte_source.hpp"
+#include <algorithm>
 #include <stdexcept>
 
 using namespace brcpp;
 
 static constexpr const size_t InitialBufferSize = 32 * 1024;
+// The most get_n() asks for at once, the window always has to cover it
+static constexpr const size_t MaxReadSize = sizeof(uint64_t);
 
 //----------------------------------------------------------------------
 file_byte_source::file_byte_source(std::shared_ptr<file_reader> reader)
-        : _reader(std::move(reader)),
-          _buffer(shared_buffer::allocate(InitialBufferSize))
+        : file_byte_source(std::move(reader), MinWindowSize, MaxWindowSize) {
+
+}
+
+//----------------------------------------------------------------------
+file_byte_source::file_byte_source(
+        std::shared_ptr<file_reader> reader,
+        size_t min_window,
+        size_t max_window,
+        std::pmr::memory_resource* resource)
+        : file_byte_source(
+                std::move(reader),
+                min_window,
+                max_window,
+                resource,
+                resource ? nullptr : window_pool()) {
+
+}
+
+//----------------------------------------------------------------------
+file_byte_source::file_byte_source(
+        std::shared_ptr<file_reader> reader,
+        size_t min_window,
+        size_t max_window,
+        std::shared_ptr<buffer_pool> pool)
+        : file_byte_source(
+                std::move(reader),
+                min_window,
+                max_window,
+                nullptr,
+                std::move(pool)) {
+
+}
+
+//----------------------------------------------------------------------
+file_byte_source::file_byte_source(
+        std::shared_ptr<file_reader> reader,
+        size_t min_window,
+        size_t max_window,
+        std::pmr::memory_resource* resource,
+        std::shared_ptr<buffer_pool> pool)
+        : _reader(std::move(reader))
+        , _alignment(std::max<size_t>(_reader->alignment(), 1))
+        , _min_window(min_window)
+        , _max_window(max_window)
+        , _resource(resource)
+        , _pool(std::move(pool))
         , _position(0), _last(0) {
 
+    if ((_alignment & (_alignment - 1)) != 0) {
+        throw std::invalid_argument("Reader alignment must be a power of two");
+    }
+
+    if (_min_window < MaxReadSize || _min_window > _max_window) {
+        throw std::invalid_argument("Invalid window size limits");
+    }
+
+    auto initial = std::clamp(InitialBufferSize, _min_window, _max_window);
+    _buffer = allocate_window(round_window(initial));
+}
+
+//----------------------------------------------------------------------
+file_byte_source::file_byte_source(const file_byte_source& other, std::shared_ptr<file_reader> reader)
+        : _reader(std::move(reader))
+        , _alignment(other._alignment)
+        , _min_window(other._min_window)
+        , _max_window(other._max_window)
+        , _resource(other._resource)
+        , _pool(other._pool)
+        , _buffer(other._buffer)    // shared until one of the two refills it
+        , _position(other._position)
+        , _last(other._last)
+        , _borrowed(other._borrowed)
+        , _pattern(other._pattern)
+        , _previous_miss(other._previous_miss)
+        , _stride(other._stride) {
+
+}
+
+//----------------------------------------------------------------------
+file_byte_source::~file_byte_source() {
+    release_window();
+    release_previous();
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<buffer_pool> file_byte_source::window_pool()
+{
+    static auto pool = std::make_shared<buffer_pool>(
+            MinWindowSize,
+            PoolAlignment,
+            MaxPooledWindows);
+    return pool;
 }
 
 //----------------------------------------------------------------------
@@ -19,19 +111,15 @@ size_t file_byte_source::get_n(uint64_t& buf, size_t bytes) {
         return 0;
     }
 
-    if (
-            _position < _last ||
-            _position + bytes >= _last + _buffer.size() ||
-            _buffer.size() == 0)
-    {
-        load_buffer();
+    auto to_shift = std::min(available(), bytes);
+    if (to_shift == 0) {
+        throw std::runtime_error("Cannot read beyond the end of the file");
     }
 
-    if (_buffer.size() == 0 && available() == 0) {
-        throw std::runtime_error("Cannot read beyond the end of the file");
+    if (_position < _last || _position + to_shift > _last + _buffer.size()) {
+        load_buffer(to_shift);
     }
 
-    auto to_shift = std::min(available(), bytes);
     for (size_t iter = 0; iter < to_shift; ++iter) {
         buf <<= 8;
         buf |= _buffer.get()[_position - _last];
@@ -75,19 +163,151 @@ void file_byte_source::skip(uint64_t bytes) {
 }
 
 //----------------------------------------------------------------------
-void file_byte_source::load_buffer()
+void file_byte_source::load_buffer(size_t bytes)
 {
-    auto read = _reader->read(_buffer.get(), _position, _buffer.capacity());
+    // Back to the window before the last jump, e.g. readers taking turns
+    if (_previous_last <= _position && _position + bytes <= _previous_last + _previous.size()) {
+        std::swap(_buffer, _previous);
+        std::swap(_last, _previous_last);
+        std::swap(_borrowed, _previous_borrowed);
+        return;
+    }
+
+    // Jumping away, keep the current window for coming back; holding it
+    // twice makes the code below load into a new one
+    if (_buffer.size() > 0 && (_position < _last || _position > _last + _buffer.size())) {
+        release_previous();
+        _previous = _buffer;
+        _previous_last = _last;
+        _previous_borrowed = _borrowed;
+    }
+
+    // Data held by the reader already, e.g. in a block cache, is read in place
+    uint64_t borrowed_start = 0;
+    auto borrowed = _reader->borrow(_position, borrowed_start);
+    if (borrowed_start <= _position && _position + bytes <= borrowed_start + borrowed.size()) {
+        release_window();
+        _buffer = std::move(borrowed);
+        _borrowed = true;
+        _last = borrowed_start;
+        return;
+    }
+
+    const bool backward = _buffer.size() > 0 && _position < _last;
+    adapt_window();
+    if (_buffer.use_count() > 1 || _borrowed) {
+        // Still shared with a clone, which expects it to stay as it is,
+        // or not ours to write to
+        auto size = std::clamp(_buffer.capacity(), _min_window, _max_window);
+        auto window = allocate_window(round_window(size));
+        release_window();
+        _buffer = std::move(window);
+    }
+
+    auto start = _position;
+    if (backward) {
+        // Stepping back usually means re-reading forward from there soon,
+        // so keep some data on both sides of the new position, but still
+        // a full read after it once the start is rounded down
+        const auto reach = MaxReadSize + _alignment - 1;
+        start -= std::min<uint64_t>({_position, _buffer.capacity() / 2, _buffer.capacity() - reach});
+    }
+
+    start &= ~static_cast<uint64_t>(_alignment - 1);
+    auto read = _reader->read(_buffer.get(), start, _buffer.capacity());
     _buffer.resize(read);
-    _last = _position;
+    _last = start;
+}
+
+//----------------------------------------------------------------------
+void file_byte_source::adapt_window()
+{
+    if (_buffer.size() == 0) {
+        _previous_miss = _position;
+        return;
+    }
+
+    const auto stride = static_cast<int64_t>(_position - _previous_miss);
+    if (_position >= _last && _position <= _last + _buffer.size()) {
+        _pattern = access_pattern::sequential;
+    } else if (stride == _stride) {
+        _pattern = access_pattern::strided;
+    } else {
+        _pattern = access_pattern::random;
+    }
+
+    _stride = stride;
+    _previous_miss = _position;
+
+    size_t next = _buffer.capacity();
+    switch (_pattern) {
+        case access_pattern::sequential:
+            next = std::min(next * 2, _max_window);
+            break;
+        case access_pattern::strided:
+            next = _min_window;
+            break;
+        case access_pattern::random:
+            next = std::max(next / 2, _min_window);
+            break;
+    }
+
+    next = round_window(next);
+    if (next != _buffer.capacity()) {
+        auto window = allocate_window(next);
+        release_window();
+        _buffer = std::move(window);
+    }
+}
+
+//----------------------------------------------------------------------
+size_t file_byte_source::round_window(size_t size) const
+{
+    if (_alignment <= 1) {
+        return size;
+    }
+
+    // The window starts up to (alignment - 1) bytes before the position,
+    // so make sure there is always at least one full block after it
+    size = std::max({size, 2 * _alignment, MaxReadSize + _alignment});
+    return (size + _alignment - 1) & ~(_alignment - 1);
+}
+
+//----------------------------------------------------------------------
+shared_buffer file_byte_source::allocate_window(size_t size) const
+{
+    // Cache line alignment at least, for vectorized consumers
+    auto alignment = std::max(_alignment, WindowAlignment);
+    if (_pool && _pool->alignment() >= alignment && _pool->pooled(size)) {
+        return _pool->acquire(size);
+    }
+
+    return shared_buffer::allocate(size, alignment, _resource);
+}
+
+//----------------------------------------------------------------------
+void file_byte_source::release_window()
+{
+    // A window still shared with a clone stays with the clone
+    if (_pool && !_borrowed && _buffer.use_count() == 1) {
+        _pool->release(std::move(_buffer));
+    }
+    _buffer = shared_buffer();
+    _borrowed = false;
+}
+
+//----------------------------------------------------------------------
+void file_byte_source::release_previous()
+{
+    if (_pool && !_previous_borrowed && _previous.use_count() == 1) {
+        _pool->release(std::move(_previous));
+    }
+    _previous = shared_buffer();
+    _previous_borrowed = false;
 }
 
 //----------------------------------------------------------------------
 std::shared_ptr<file_byte_source> file_byte_source::clone()
 {
-    auto ret = std::make_shared<file_byte_source>(_reader->clone());
-    ret->_buffer = shared_buffer::clone(_buffer);
-    ret->_position = _position;
-    ret->_last = _last;
-    return ret;
+    return std::shared_ptr<file_byte_source>(new file_byte_source(*this, _reader->clone()));
 }
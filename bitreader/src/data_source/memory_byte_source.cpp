@@ -4,15 +4,32 @@ using namespace brcpp;
 
 //----------------------------------------------------------------------
 memory_byte_source::memory_byte_source()
+        : _begin(nullptr), _end(nullptr), _current(nullptr)
 {
-    _current = nullptr;
+
 }
 
 //----------------------------------------------------------------------
 memory_byte_source::memory_byte_source(const uint8_t* data, size_t size)
-        : _data(shared_buffer::copy_mem(data, size))
+        : memory_byte_source(shared_buffer::copy_mem(data, size))
+{
+
+}
+
+//----------------------------------------------------------------------
+memory_byte_source::memory_byte_source(borrow_memory_t, const uint8_t* data, size_t size)
+        : _begin(data), _end(data + size), _current(data)
+{
+
+}
+
+//----------------------------------------------------------------------
+memory_byte_source::memory_byte_source(shared_buffer data)
+        : _data(std::move(data))
 {
-    _current = _data.begin();
+    _begin = _data.cbegin();
+    _end = _data.cend();
+    _current = _begin;
 }
 
 //----------------------------------------------------------------------
@@ -22,7 +39,7 @@ size_t memory_byte_source::get_n(uint64_t& buf, size_t bytes)
         return 0;
     }
 
-    if (_current == _data.end()) {
+    if (_current == _end) {
         throw std::runtime_error("Access beyond data buffer boundaries");
     }
 
@@ -46,23 +63,23 @@ bool memory_byte_source::depleted()
 //----------------------------------------------------------------------
 uint64_t memory_byte_source::available()
 {
-    return static_cast<uint64_t>(_data.end() - _current);
+    return static_cast<uint64_t>(_end - _current);
 }
 
 //----------------------------------------------------------------------
 uint64_t memory_byte_source::position()
 {
-    return static_cast<uint64_t>(_current - _data.begin());
+    return static_cast<uint64_t>(_current - _begin);
 }
 
 //----------------------------------------------------------------------
 void memory_byte_source::seek(uint64_t position)
 {
-    if (position > _data.size()) {
+    if (position > static_cast<uint64_t>(_end - _begin)) {
         throw std::range_error("Position outside of the data buffer");
     }
 
-    _current = _data.begin() + position;
+    _current = _begin + position;
 }
 
 //----------------------------------------------------------------------
@@ -78,8 +95,7 @@ void memory_byte_source::skip(uint64_t bytes)
 //----------------------------------------------------------------------
 std::shared_ptr<memory_byte_source> memory_byte_source::clone()
 {
-    auto ret = std::make_shared<memory_byte_source>();
-    ret->_data = shared_buffer::clone(_data);
-    ret->_current = ret->_data.begin() + position();
-    return ret;
+    // The data is never written through a source, so clones share it
+    // and only get their own cursor
+    return std::make_shared<memory_byte_source>(*this);
 }
@@ -0,0 +1,163 @@
+#include "bitreader/data_source/multi_file_byte_source.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+multi_file_byte_source::multi_file_byte_source(
+        std::vector<std::shared_ptr<file_reader>> readers)
+        : _readers(std::move(readers))
+        , _owned(_readers.size(), true)
+{
+    uint64_t offset = 0;
+    for (const auto& reader: _readers) {
+        if (!reader) {
+            throw std::invalid_argument("Null file reader in the segment list");
+        }
+        _offsets.push_back(offset);
+        offset += reader->size();
+    }
+    _offsets.push_back(offset);
+}
+
+//----------------------------------------------------------------------
+multi_file_byte_source::multi_file_byte_source(
+        std::vector<std::shared_ptr<file_reader>> readers,
+        std::vector<uint64_t> offsets)
+        : _readers(std::move(readers))
+        , _owned(_readers.size(), false)
+        , _offsets(std::move(offsets))
+{
+}
+
+//----------------------------------------------------------------------
+size_t multi_file_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (available() == 0) {
+        throw std::runtime_error("Cannot read beyond the end of the last file");
+    }
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+    size_t done = 0;
+    while (done < to_shift) {
+        if (!_current || _current->available() == 0) {
+            seek(_position);
+        }
+
+        auto got = _current->get_n(buf, to_shift - done);
+        done += got;
+        _position += got;
+    }
+
+    prefetch_next();
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+bool multi_file_byte_source::depleted()
+{
+    return std::all_of(_readers.begin(), _readers.end(), [] (const auto& reader) {
+        return reader->depleted();
+    });
+}
+
+//----------------------------------------------------------------------
+uint64_t multi_file_byte_source::available()
+{
+    return size() - _position;
+}
+
+//----------------------------------------------------------------------
+uint64_t multi_file_byte_source::position()
+{
+    return _position;
+}
+
+//----------------------------------------------------------------------
+void multi_file_byte_source::seek(uint64_t position)
+{
+    if (position > size()) {
+        throw std::range_error("Cannot seek beyond the end of the last file");
+    }
+
+    // Last non-empty segment starting at or before the position
+    auto found = std::upper_bound(_offsets.begin(), _offsets.end() - 1, position);
+    auto segment = static_cast<size_t>(found - _offsets.begin());
+    segment = segment > 0 ? segment - 1 : 0;
+
+    _position = position;
+    if (segment < _readers.size()) {
+        enter(segment);
+        _current->seek(position - _offsets[segment]);
+    }
+}
+
+//----------------------------------------------------------------------
+void multi_file_byte_source::skip(uint64_t bytes)
+{
+    if (bytes > available()) {
+        throw std::range_error("Cannot skip beyond the end of the last file");
+    }
+
+    seek(_position + bytes);
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<multi_file_byte_source> multi_file_byte_source::clone()
+{
+    // The readers are stateful, the clone gets its own as it reaches them
+    auto ret = std::shared_ptr<multi_file_byte_source>(
+            new multi_file_byte_source(_readers, _offsets));
+    ret->seek(_position);
+    return ret;
+}
+
+//----------------------------------------------------------------------
+void multi_file_byte_source::enter(size_t segment)
+{
+    if (_current && _segment == segment) {
+        return;
+    }
+
+    // Keep the segment left behind, seeks often go back and forth over
+    // a boundary; the one before goes, its window back to the pool
+    if (_previous && _previous_segment == segment) {
+        std::swap(_current, _previous);
+    } else {
+        _previous = std::move(_current);
+        _current = std::make_shared<file_byte_source>(reader(segment));
+    }
+
+    _previous_segment = _segment;
+    _segment = segment;
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<file_reader> multi_file_byte_source::reader(size_t segment)
+{
+    if (!_owned[segment]) {
+        _readers[segment] = _readers[segment]->clone();
+        _owned[segment] = true;
+    }
+
+    return _readers[segment];
+}
+
+//----------------------------------------------------------------------
+void multi_file_byte_source::prefetch_next()
+{
+    auto next = _segment + 1;
+    if (next >= _readers.size() || _prefetched == next) {
+        return;
+    }
+
+    if (_offsets[next] - _position <= PrefetchDistance) {
+        reader(next)->prefetch(0, PrefetchDistance);
+        _prefetched = next;
+    }
+}
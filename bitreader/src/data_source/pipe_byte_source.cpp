@@ -0,0 +1,254 @@
+#include "bitreader/data_source/pipe_byte_source.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace brcpp;
+
+namespace
+{
+    constexpr const size_t ReadChunk = 64 * 1024;
+
+    //--------------------------------------------------------------------------
+    class pipe_input
+    {
+    public:
+        virtual ~pipe_input() = default;
+
+        /**
+         * @brief Read whatever is ready, waiting only if nothing is
+         * @return Number of bytes read, 0 at the end of input
+         */
+        virtual size_t read(uint8_t* dest, size_t bytes) = 0;
+    };
+
+    //--------------------------------------------------------------------------
+    class fd_input: public pipe_input
+    {
+    public:
+        explicit fd_input(int fd): _fd(fd) {}
+
+        size_t read(uint8_t* dest, size_t bytes) override
+        {
+            while (true) {
+#ifdef WIN32
+                auto result = ::_read(_fd, dest, static_cast<unsigned>(std::min<size_t>(bytes, 0x7FFFFFFF)));
+#else
+                auto result = ::read(_fd, dest, bytes);
+#endif
+                if (result >= 0) {
+                    return static_cast<size_t>(result);
+                } else if (errno != EINTR) {
+                    throw std::runtime_error("Could not read from file descriptor");
+                }
+            }
+        }
+
+    private:
+        int _fd;
+    };
+
+    //--------------------------------------------------------------------------
+    class stream_input: public pipe_input
+    {
+    public:
+        explicit stream_input(std::istream& stream): _stream(stream) {}
+
+        size_t read(uint8_t* dest, size_t bytes) override
+        {
+            // sgetn() alone would wait for the whole request to arrive
+            auto buffer = _stream.rdbuf();
+            auto ready = buffer->in_avail();
+            if (ready <= 0) {
+                if (std::istream::traits_type::eq_int_type(
+                        buffer->sgetc(),
+                        std::istream::traits_type::eof())) {
+                    return 0;
+                }
+                ready = std::max<std::streamsize>(buffer->in_avail(), 1);
+            }
+
+            auto wanted = std::min<std::streamsize>(ready, static_cast<std::streamsize>(bytes));
+            auto got = buffer->sgetn(reinterpret_cast<char*>(dest), wanted);
+            return static_cast<size_t>(std::max<std::streamsize>(got, 0));
+        }
+
+    private:
+        std::istream& _stream;
+    };
+}
+
+//------------------------------------------------------------------------------
+struct pipe_byte_source::ring
+{
+    ring(std::unique_ptr<pipe_input> input, size_t look_behind)
+        : input(std::move(input))
+        , look_behind(look_behind)
+        , data(look_behind + ReadChunk)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    // Buffer up to `target`, dropping data more than look_behind bytes
+    // before `position` when space is needed
+    void fill(uint64_t position, uint64_t target)
+    {
+        while (end < target && !eof) {
+            if (position > look_behind) {
+                begin = std::max(begin, position - look_behind);
+            }
+
+            const size_t capacity = data.size();
+            const auto used = static_cast<size_t>(end - begin);
+            const auto offset = static_cast<size_t>(end % capacity);
+            const size_t free = std::min(capacity - used, capacity - offset);
+            if (free == 0) {
+                throw std::logic_error("Pipe ring buffer overflow");
+            }
+
+            auto got = input->read(data.data() + offset, free);
+            if (got == 0) {
+                eof = true;
+            }
+            end += got;
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    uint8_t at(uint64_t position) const
+    {
+        return data[static_cast<size_t>(position % data.size())];
+    }
+
+    std::unique_ptr<pipe_input> input;
+    size_t look_behind;
+    std::vector<uint8_t> data;
+    uint64_t begin = 0;     // stream offset of the oldest byte kept
+    uint64_t end = 0;       // stream offset right past the newest byte
+    bool eof = false;
+};
+
+//----------------------------------------------------------------------
+pipe_byte_source::pipe_byte_source(int fd, size_t look_behind)
+        : pipe_byte_source(std::make_shared<ring>(std::make_unique<fd_input>(fd), look_behind))
+{
+
+}
+
+//----------------------------------------------------------------------
+pipe_byte_source::pipe_byte_source(std::istream& stream, size_t look_behind)
+        : pipe_byte_source(std::make_shared<ring>(std::make_unique<stream_input>(stream), look_behind))
+{
+
+}
+
+//----------------------------------------------------------------------
+pipe_byte_source::pipe_byte_source(std::shared_ptr<ring> ring)
+        : _ring(std::move(ring))
+{
+
+}
+
+//----------------------------------------------------------------------
+size_t pipe_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (_position < _ring->begin) {
+        throw std::range_error("Data before the look-behind window is no longer buffered");
+    }
+
+    // Wait only if nothing is buffered ahead, and never ask for more than
+    // the ring can hold ahead of the position
+    auto wanted = std::min<uint64_t>(bytes, ReadChunk);
+    _ring->fill(_position, _position + 1);
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(wanted, _ring->end - _position));
+    if (to_shift == 0) {
+        throw std::runtime_error("Cannot read beyond the end of input");
+    }
+
+    for (size_t iter = 0; iter < to_shift; ++iter) {
+        buf = (buf << 8) | _ring->at(_position + iter);
+    }
+
+    _position += to_shift;
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+bool pipe_byte_source::depleted()
+{
+    // Reads block until data arrives, so running out means the end
+    return true;
+}
+
+//----------------------------------------------------------------------
+uint64_t pipe_byte_source::available()
+{
+    // An interactive input may have only a few bytes pending, those are
+    // reported as they are; waiting is only needed when there are none
+    _ring->fill(_position, _position + 1);
+    return _ring->end > _position ? _ring->end - _position : 0;
+}
+
+//----------------------------------------------------------------------
+uint64_t pipe_byte_source::position()
+{
+    return _position;
+}
+
+//----------------------------------------------------------------------
+void pipe_byte_source::seek(uint64_t position)
+{
+    if (position < _ring->begin) {
+        throw std::range_error("Cannot seek before the look-behind window");
+    }
+
+    // Read through to the target one chunk at a time
+    while (_ring->end < position && !_ring->eof) {
+        auto step = std::min<uint64_t>(position, _ring->end + ReadChunk);
+        _ring->fill(_ring->end, step);
+    }
+
+    // The position stays as it was; reading there fails only if reading
+    // through dropped it from the look-behind window
+    if (position > _ring->end) {
+        throw std::range_error("Cannot seek beyond the end of input");
+    }
+
+    _position = position;
+}
+
+//----------------------------------------------------------------------
+void pipe_byte_source::skip(uint64_t bytes)
+{
+    seek(_position + bytes);
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<pipe_byte_source> pipe_byte_source::clone()
+{
+    auto ret = std::shared_ptr<pipe_byte_source>(new pipe_byte_source(_ring));
+    ret->_position = _position;
+    return ret;
+}
+
+//----------------------------------------------------------------------
+std::optional<uint64_t> pipe_byte_source::size() const
+{
+    if (_ring->eof) {
+        return _ring->end;
+    }
+
+    return std::nullopt;
+}
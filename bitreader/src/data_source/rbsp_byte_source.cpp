@@ -0,0 +1,235 @@
+#include "bitreader/data_source/rbsp_byte_source.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+#include "bitreader/common/byte_scan.hpp"
+
+using namespace brcpp;
+
+namespace
+{
+    // How far ahead escapes are searched at once; enough for a slice
+    // header, and long runs are what the vectorized scan is fast at
+    constexpr const size_t ScanChunk = 1024;
+    constexpr const size_t Lookahead = 16;
+}
+
+//----------------------------------------------------------------------
+rbsp_byte_source::rbsp_byte_source()
+        : _begin(nullptr), _end(nullptr), _current(nullptr)
+{
+
+}
+
+//----------------------------------------------------------------------
+rbsp_byte_source::rbsp_byte_source(const uint8_t* data, size_t size)
+        : rbsp_byte_source(shared_buffer::copy_mem(data, size))
+{
+
+}
+
+//----------------------------------------------------------------------
+rbsp_byte_source::rbsp_byte_source(borrow_memory_t, const uint8_t* data, size_t size)
+        : _begin(data), _end(data + size), _current(data)
+{
+
+}
+
+//----------------------------------------------------------------------
+rbsp_byte_source::rbsp_byte_source(shared_buffer data)
+        : _data(std::move(data))
+{
+    _begin = _data.cbegin();
+    _end = _data.cend();
+    _current = _begin;
+}
+
+//----------------------------------------------------------------------
+void rbsp_byte_source::scan_to(uint64_t limit)
+{
+    static constexpr const uint8_t EscapeSequence[] = {0x00, 0x00, 0x03};
+
+    const auto size = original_size();
+    if (_scanned >= std::min(limit, size)) {
+        return;
+    }
+
+    limit = std::min(size, std::max(limit, _scanned + ScanChunk));
+
+    // A sequence may straddle the previous limit, but it cannot overlap
+    // the last escape: the 03 would have to be one of the zeros
+    uint64_t from = _scanned - std::min<uint64_t>(_scanned, 2);
+    if (!_escapes.empty()) {
+        from = std::max(from, _escapes.back() + 1);
+    }
+
+    const auto end = _begin + limit;
+    auto found = find_bytes(_begin + from, end, EscapeSequence, sizeof(EscapeSequence));
+    while (found != end) {
+        _escapes.push_back(static_cast<uint64_t>(found + 2 - _begin));
+        found = find_bytes(found + 3, end, EscapeSequence, sizeof(EscapeSequence));
+    }
+
+    _scanned = limit;
+}
+
+//----------------------------------------------------------------------
+size_t rbsp_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (_current == _end) {
+        throw std::runtime_error("Access beyond data buffer boundaries");
+    }
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+    auto escape = next_escape();
+
+    // Copy the runs between escapes, _current never rests on an escape
+    size_t done = 0;
+    while (done < to_shift) {
+        auto run = std::min(to_shift - done, static_cast<size_t>(escape - _current));
+        for (size_t iter = 0; iter < run; ++iter) {
+            buf <<= 8;
+            buf |= _current[iter];
+        }
+
+        _current += run;
+        done += run;
+
+        if (_current == escape) {
+            if (_next_escape < _escapes.size()) {
+                ++_current;
+                ++_next_escape;
+            } else {
+                // Only the end of what has been scanned so far
+                scan_to(original_position() + 1);
+            }
+            escape = next_escape();
+        }
+    }
+
+    _position += to_shift;
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+bool rbsp_byte_source::depleted()
+{
+    return true;
+}
+
+//----------------------------------------------------------------------
+uint64_t rbsp_byte_source::available()
+{
+    // Exact once the scan has reached the end
+    const auto current = original_position();
+    scan_to(current + Lookahead);
+    return _scanned - current - (_escapes.size() - _next_escape);
+}
+
+//----------------------------------------------------------------------
+uint64_t rbsp_byte_source::position()
+{
+    return _position;
+}
+
+//----------------------------------------------------------------------
+void rbsp_byte_source::seek(uint64_t position)
+{
+    auto escapes = escapes_before(position);
+    if (position + escapes > original_size()) {
+        throw std::range_error("Position outside of the data buffer");
+    }
+
+    _next_escape = escapes;
+    _current = _begin + position + escapes;
+    _position = position;
+}
+
+//----------------------------------------------------------------------
+void rbsp_byte_source::skip(uint64_t bytes)
+{
+    auto escapes = escapes_before(_position + bytes);
+    if (_position + bytes + escapes > original_size()) {
+        throw std::range_error("Cannot skip beyond the boundaries of the data buffer");
+    }
+
+    seek(_position + bytes);
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<rbsp_byte_source> rbsp_byte_source::clone()
+{
+    return std::make_shared<rbsp_byte_source>(*this);
+}
+
+//----------------------------------------------------------------------
+uint64_t rbsp_byte_source::original_position(uint64_t position)
+{
+    auto escapes = escapes_before(position);
+    if (position + escapes > original_size()) {
+        throw std::range_error("Position outside of the data buffer");
+    }
+
+    return position + escapes;
+}
+
+//----------------------------------------------------------------------
+size_t rbsp_byte_source::escapes()
+{
+    scan_to(original_size());
+    return _escapes.size();
+}
+
+//----------------------------------------------------------------------
+size_t rbsp_byte_source::escapes_before(uint64_t position)
+{
+    // The byte at the position has to be inside the scanned part,
+    // otherwise escapes yet to be found could still come before it
+    auto count = known_escapes_before(position);
+    while (_scanned < original_size() && position + count >= _scanned) {
+        scan_to(position + count + 1);
+        count = known_escapes_before(position);
+    }
+
+    return count;
+}
+
+//----------------------------------------------------------------------
+size_t rbsp_byte_source::known_escapes_before(uint64_t position) const
+{
+    // Escape N sits right after RBSP byte (offset - N - 1), the offsets
+    // reduced that way are strictly increasing and can be bisected
+    size_t low = 0;
+    size_t high = _escapes.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (_escapes[middle] - middle <= position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+//----------------------------------------------------------------------
+const uint8_t* rbsp_byte_source::next_escape() const
+{
+    if (_next_escape < _escapes.size()) {
+        return _begin + _escapes[_next_escape];
+    }
+
+    // Nothing known ahead, stop at the end of the scanned part
+    return _begin + _scanned;
+}
+
+//----------------------------------------------------------------------
+uint64_t rbsp_byte_source::original_size() const
+{
+    return static_cast<uint64_t>(_end - _begin);
+}
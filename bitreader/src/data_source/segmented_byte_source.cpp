@@ -0,0 +1,142 @@
+#include "bitreader/data_source/segmented_byte_source.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+segmented_byte_source::segmented_byte_source()
+        : segmented_byte_source(std::vector<shared_buffer>{})
+{
+
+}
+
+//----------------------------------------------------------------------
+segmented_byte_source::segmented_byte_source(std::vector<shared_buffer> segments)
+{
+    auto state = std::make_shared<layout>();
+    uint64_t offset = 0;
+    for (auto& segment: segments) {
+        if (segment.size() == 0) {
+            continue;
+        }
+
+        state->offsets.push_back(offset);
+        offset += segment.size();
+        state->segments.push_back(std::move(segment));
+    }
+    state->offsets.push_back(offset);
+
+    _layout = std::move(state);
+    enter(0, 0);
+}
+
+//----------------------------------------------------------------------
+size_t segmented_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (available() == 0) {
+        throw std::runtime_error("Access beyond the end of the segments");
+    }
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+    auto in_segment = static_cast<size_t>(_segment_end - _current);
+    if (to_shift <= in_segment) {
+        for (size_t iter = 0; iter < to_shift; ++iter) {
+            buf = (buf << 8) | _current[iter];
+        }
+        _current += to_shift;
+    } else {
+        for (size_t iter = 0; iter < to_shift; ++iter) {
+            if (_current == _segment_end) {
+                enter(_segment + 1, 0);
+            }
+            buf = (buf << 8) | *_current++;
+        }
+    }
+
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+bool segmented_byte_source::depleted()
+{
+    return true;
+}
+
+//----------------------------------------------------------------------
+uint64_t segmented_byte_source::available()
+{
+    return size() - position();
+}
+
+//----------------------------------------------------------------------
+uint64_t segmented_byte_source::position()
+{
+    if (_segment == _layout->segments.size()) {
+        return size();
+    }
+
+    auto start = _layout->segments[_segment].cbegin();
+    return _layout->offsets[_segment] + static_cast<uint64_t>(_current - start);
+}
+
+//----------------------------------------------------------------------
+void segmented_byte_source::seek(uint64_t position)
+{
+    if (position > size()) {
+        throw std::range_error("Position outside of the segments");
+    }
+
+    if (position == size()) {
+        enter(_layout->segments.size(), 0);
+        return;
+    }
+
+    // Last segment starting at or before the position
+    const auto& offsets = _layout->offsets;
+    auto found = std::upper_bound(offsets.begin(), offsets.end() - 1, position);
+    auto segment = static_cast<size_t>(found - offsets.begin() - 1);
+    enter(segment, static_cast<size_t>(position - offsets[segment]));
+}
+
+//----------------------------------------------------------------------
+void segmented_byte_source::skip(uint64_t bytes)
+{
+    if (bytes > available()) {
+        throw std::range_error("Cannot skip beyond the end of the segments");
+    }
+
+    auto in_segment = static_cast<uint64_t>(_segment_end - _current);
+    if (bytes < in_segment) {
+        _current += bytes;
+    } else {
+        seek(position() + bytes);
+    }
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<segmented_byte_source> segmented_byte_source::clone()
+{
+    return std::make_shared<segmented_byte_source>(*this);
+}
+
+//----------------------------------------------------------------------
+void segmented_byte_source::enter(size_t segment, size_t offset)
+{
+    _segment = segment;
+    if (segment < _layout->segments.size()) {
+        // Use the sizes recorded on construction, in case the owner of a
+        // segment resizes it afterwards
+        const auto& offsets = _layout->offsets;
+        auto start = _layout->segments[segment].cbegin();
+        _current = start + offset;
+        _segment_end = start + (offsets[segment + 1] - offsets[segment]);
+    } else {
+        _current = nullptr;
+        _segment_end = nullptr;
+    }
+}
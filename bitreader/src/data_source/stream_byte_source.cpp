@@ -0,0 +1,156 @@
+#include "bitreader/data_source/stream_byte_source.hpp"
+
+using namespace brcpp;
+
+//----------------------------------------------------------------------
+stream_byte_source::stream_byte_source()
+        : stream_byte_source(DefaultLookBehind)
+{
+
+}
+
+//----------------------------------------------------------------------
+stream_byte_source::stream_byte_source(size_t look_behind)
+        : _look_behind(look_behind)
+{
+
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::push(const uint8_t* data, size_t size)
+{
+    push(shared_buffer::copy_mem(data, size));
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::push(shared_buffer chunk)
+{
+    if (_finished) {
+        throw std::runtime_error("Cannot push data after the end of stream");
+    }
+
+    if (chunk.size() == 0) {
+        return;
+    }
+
+    _end += chunk.size();
+    _chunks.push_back(std::move(chunk));
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::finish()
+{
+    _finished = true;
+}
+
+//----------------------------------------------------------------------
+size_t stream_byte_source::get_n(uint64_t& buf, size_t bytes)
+{
+    if (bytes == 0) {
+        return 0;
+    }
+
+    if (_position == _end) {
+        underflow("Access beyond the end of stream");
+    }
+
+    auto to_shift = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+    for (size_t iter = 0; iter < to_shift; ++iter) {
+        if (_offset == _chunks[_chunk].size()) {
+            ++_chunk;
+            _offset = 0;
+        }
+
+        buf <<= 8;
+        buf |= _chunks[_chunk][_offset];
+        ++_offset;
+    }
+
+    _position += to_shift;
+    trim();
+    return to_shift;
+}
+
+//----------------------------------------------------------------------
+bool stream_byte_source::depleted()
+{
+    return _finished;
+}
+
+//----------------------------------------------------------------------
+uint64_t stream_byte_source::available()
+{
+    return _end - _position;
+}
+
+//----------------------------------------------------------------------
+uint64_t stream_byte_source::position()
+{
+    return _position;
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::seek(uint64_t position)
+{
+    if (position < _base) {
+        throw std::range_error("Cannot seek to data that has been discarded");
+    }
+
+    if (position > _end) {
+        underflow("Cannot seek beyond the end of stream");
+    }
+
+    locate(position);
+    trim();
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::skip(uint64_t bytes)
+{
+    if (bytes > available()) {
+        underflow("Cannot skip beyond the end of stream");
+    }
+
+    locate(_position + bytes);
+    trim();
+}
+
+//----------------------------------------------------------------------
+std::shared_ptr<stream_byte_source> stream_byte_source::clone()
+{
+    // Chunks are never modified once pushed, so sharing them is enough
+    return std::make_shared<stream_byte_source>(*this);
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::locate(uint64_t position)
+{
+    _chunk = 0;
+    _offset = static_cast<size_t>(position - _base);
+    while (_chunk < _chunks.size() && _offset > _chunks[_chunk].size()) {
+        _offset -= _chunks[_chunk].size();
+        ++_chunk;
+    }
+
+    _position = position;
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::trim()
+{
+    while (_chunk > 0 && _base + _chunks.front().size() + _look_behind <= _position) {
+        _base += _chunks.front().size();
+        _chunks.pop_front();
+        --_chunk;
+    }
+}
+
+//----------------------------------------------------------------------
+void stream_byte_source::underflow(const char* message) const
+{
+    if (_finished) {
+        throw std::range_error(message);
+    } else {
+        throw need_more_data(message);
+    }
+}
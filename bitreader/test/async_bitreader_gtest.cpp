@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <bitreader/async_bitreader.hpp>
+#include <bitreader/codings/exp-golomb-k0.hpp>
+#include <bitreader/data_source/memory_byte_source.hpp>
+#include <bitreader/data_source/stream_byte_source.hpp>
+
+using namespace brcpp;
+
+namespace {
+    using reader_t = async_bitreader<stream_byte_source>;
+
+    struct header {
+        uint8_t type;
+        uint32_t length;
+    };
+
+    //--------------------------------------------------------------------------
+    parse_task<header> parse_header(reader_t& r)
+    {
+        header ret{};
+        ret.type = co_await r.read<uint8_t>(4);
+        co_await r.skip(4);
+        ret.length = co_await r.read<uint32_t>(24);
+        co_return ret;
+    }
+
+    //--------------------------------------------------------------------------
+    parse_task<uint64_t> parse_records(reader_t& r, size_t count)
+    {
+        uint64_t sum = 0;
+        for (size_t iter = 0; iter < count; ++iter) {
+            auto h = co_await parse_header(r);
+            sum += h.type;
+            sum += co_await r.read<uint32_t>(h.length);
+        }
+        co_return sum;
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(asyncBitreaderTest, completesWithoutSuspending)
+{
+    auto source = std::make_shared<stream_byte_source>();
+    const uint8_t data[] = {0x3F, 0x00, 0x00, 0x08, 0x05};
+    source->push(data, sizeof(data));
+    source->finish();
+
+    reader_t r(source);
+    auto task = parse_records(r, 1);
+    ASSERT_TRUE(task.done());
+    EXPECT_EQ(3 + 5, task.get());
+    EXPECT_FALSE(r.waiting());
+}
+
+//------------------------------------------------------------------------------
+TEST(asyncBitreaderTest, resumesByteByByte)
+{
+    auto source = std::make_shared<stream_byte_source>();
+    const uint8_t data[] = {
+        0x3F, 0x00, 0x00, 0x08, 0x05,
+        0x10, 0x00, 0x00, 0x10, 0x01, 0x00,
+    };
+
+    reader_t r(source);
+    auto task = parse_records(r, 2);
+    size_t resumes = 0;
+    for (auto byte: data) {
+        EXPECT_FALSE(task.done());
+        EXPECT_TRUE(r.waiting());
+        source->push(&byte, 1);
+        if (r.resume()) {
+            ++resumes;
+        }
+    }
+
+    ASSERT_TRUE(task.done());
+    EXPECT_EQ(3 + 5 + 1 + 256, task.get());
+    EXPECT_EQ(88, r.position());
+    EXPECT_GE(resumes, 6);
+}
+
+//------------------------------------------------------------------------------
+TEST(asyncBitreaderTest, endOfStreamFailsTask)
+{
+    auto source = std::make_shared<stream_byte_source>();
+    const uint8_t data[] = {0x3F, 0x00};
+    source->push(data, sizeof(data));
+
+    reader_t r(source);
+    auto task = parse_records(r, 1);
+    EXPECT_FALSE(task.done());
+    EXPECT_FALSE(r.resume());
+
+    source->finish();
+    EXPECT_TRUE(r.resume());
+    ASSERT_TRUE(task.done());
+    EXPECT_THROW(task.get(), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+TEST(asyncBitreaderTest, ensureForCodecs)
+{
+    auto source = std::make_shared<stream_byte_source>();
+    reader_t r(source);
+
+    auto task = [] (reader_t& r) -> parse_task<uint8_t> {
+        co_await r.ensure(16);
+        co_return r.reader().read<ext::exp_golomb_k0<uint8_t>>();
+    }(r);
+
+    const uint8_t data[] = {0b00011010, 0x00};
+    source->push(data, 1);
+    EXPECT_FALSE(r.resume());
+    source->push(data + 1, 1);
+    EXPECT_TRUE(r.resume());
+    ASSERT_TRUE(task.done());
+    EXPECT_EQ(0b1101 - 1, task.get());
+}
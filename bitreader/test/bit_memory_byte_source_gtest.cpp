@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/bit_memory_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    uint8_t reference_byte(const uint8_t* data, uint64_t bit_offset, uint64_t bit_size, uint64_t index)
+    {
+        uint8_t ret = 0;
+        for (uint64_t bit = 0; bit < 8; ++bit) {
+            uint64_t at = 8 * index + bit;
+            ret = static_cast<uint8_t>(ret << 1);
+            if (at < bit_size) {
+                at += bit_offset;
+                ret = static_cast<uint8_t>(ret | ((data[at / 8] >> (7 - at % 8)) & 1));
+            }
+        }
+        return ret;
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(bitMemoryByteSourceTest, emptyCtor)
+{
+    bit_memory_byte_source src;
+    uint64_t buf = 0;
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+    EXPECT_TRUE(src.depleted());
+    EXPECT_EQ(0, src.available());
+    EXPECT_EQ(0, src.bit_size());
+    EXPECT_NO_THROW(src.seek(0));
+    EXPECT_ANY_THROW(src.seek(1));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitMemoryByteSourceTest, shiftedBytes)
+{
+    const size_t size = 40;
+    std::unique_ptr<uint8_t[]> data{generate_test_data(size)};
+
+    for (uint64_t offset = 0; offset < 16; ++offset) {
+        for (uint64_t bits : {0u, 5u, 8u, 63u, 64u, 100u, 250u}) {
+            for (size_t chunk = 1; chunk <= 8; ++chunk) {
+                bit_memory_byte_source src(borrow_memory, data.get(), offset, bits);
+                EXPECT_EQ((bits + 7) / 8, src.available());
+
+                uint64_t index = 0;
+                while (src.available() > 0) {
+                    uint64_t buf = 0;
+                    auto got = src.get_n(buf, chunk);
+                    for (size_t iter = got; iter > 0; --iter) {
+                        auto byte = static_cast<uint8_t>(buf >> (8 * (iter - 1)));
+                        ASSERT_EQ(reference_byte(data.get(), offset, bits, index), byte)
+                                << "offset " << offset << " bits " << bits << " byte " << index;
+                        ++index;
+                    }
+                }
+                EXPECT_EQ((bits + 7) / 8, index);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(bitMemoryByteSourceTest, ownership)
+{
+    const uint8_t data[] = {0x12, 0x34, 0x56};
+
+    bit_memory_byte_source copy(data, 4, 16);
+    bit_memory_byte_source shared(shared_buffer::copy_mem(data, sizeof(data)), 4, 16);
+    for (auto* src : {&copy, &shared}) {
+        uint64_t buf = 0;
+        EXPECT_EQ(2, src->get_n(buf, 8));
+        EXPECT_EQ(0x2345, buf);
+    }
+
+    EXPECT_THROW(bit_memory_byte_source(shared_buffer::copy_mem(data, sizeof(data)), 4, 21),
+                 std::invalid_argument);
+}
+
+//------------------------------------------------------------------------------
+TEST(bitMemoryByteSourceTest, seekAndClone)
+{
+    const size_t size = 64;
+    std::unique_ptr<uint8_t[]> data{generate_test_data(size)};
+    bit_memory_byte_source src(borrow_memory, data.get(), 3, 400);
+
+    src.seek(20);
+    auto copy = src.clone();
+    src.skip(10);
+    EXPECT_EQ(30, src.position());
+    EXPECT_EQ(20, copy->position());
+
+    uint64_t buf = 0;
+    copy->get_n(buf, 1);
+    EXPECT_EQ(reference_byte(data.get(), 3, 400, 20), buf);
+
+    EXPECT_ANY_THROW(src.seek(51));
+    EXPECT_ANY_THROW(src.skip(21));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitMemoryByteSourceTest, bitreaderHonoursBitSize)
+{
+    // 11 bits starting at bit 5: 1 0110 1001 01
+    const uint8_t data[] = {0xFD, 0xA5, 0x7F};
+    auto src = std::make_shared<bit_memory_byte_source>(borrow_memory, data, 5, 11);
+    bitreader<bit_memory_byte_source> br(src);
+
+    EXPECT_EQ(11, br.available());
+    EXPECT_EQ(11, br.end());
+    EXPECT_EQ(0x5A5, br.read<uint32_t>(11));
+    EXPECT_EQ(0, br.available());
+    EXPECT_THROW(br.read<uint8_t>(1), std::runtime_error);
+}
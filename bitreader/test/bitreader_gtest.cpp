@@ -1,6 +1,7 @@
 #include <bit>
 #include <gtest/gtest.h>
 #include <bitreader/data_source/memory_byte_source.hpp>
+#include <bitreader/data_source/stream_byte_source.hpp>
 #include "bitreader/bitreader.hpp"
 #include "bitreader/codings/exp-golomb-k0.hpp"
 
@@ -526,4 +527,170 @@ TEST(bitreaderTest, read_double_insufficient_data)
     EXPECT_THROW(br.read<double>(64), std::exception);
     EXPECT_EQ(0, br.position());
     EXPECT_EQ(56, br.available());
-}
\ No newline at end of file
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, resume_after_more_data)
+{
+    const uint8_t first[] = {0xAB, 0xCD, 0xEF};
+    const uint8_t second[] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+
+    auto source = std::make_shared<stream_byte_source>();
+    bitreader<stream_byte_source> br(source);
+    EXPECT_THROW(br.read<uint8_t>(1), need_more_data);
+    EXPECT_EQ(0, br.position());
+
+    source->push(first, sizeof(first));
+    EXPECT_EQ(0xA, br.read<uint8_t>(4));
+    EXPECT_THROW(br.read<uint32_t>(32), need_more_data);
+    EXPECT_THROW(br.skip(21), need_more_data);
+    EXPECT_EQ(4, br.position());
+    EXPECT_EQ(20, br.available());
+
+    source->push(second, sizeof(second));
+    EXPECT_EQ(0xBCDEF123, br.read<uint32_t>(32));
+    EXPECT_EQ(0x456789ABCDEF0, br.read<uint64_t>(52));
+    EXPECT_THROW(br.read<uint8_t>(1), need_more_data);
+
+    source->finish();
+    EXPECT_THROW(br.read<uint8_t>(1), std::runtime_error);
+    try {
+        br.read<uint8_t>(1);
+    } catch (const need_more_data&) {
+        FAIL() << "Depleted source must report the end of stream";
+    } catch (const std::runtime_error&) {
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, subreader)
+{
+    // Two TLV records: type (8), length in bytes (8), payload
+    const uint8_t data[] = {
+        0x01, 0x03, 0xAA, 0xBB, 0xCC,
+        0x02, 0x02, 0x11, 0x22
+    };
+    auto source = std::make_shared<source_t>(data, sizeof(data));
+    bitreader<source_t> br(source);
+
+    EXPECT_EQ(0x01, br.read<uint8_t>(8));
+    auto length = br.read<size_t>(8) * 8;
+    auto record = br.subreader(length);
+    br.skip(length);
+
+    EXPECT_EQ(16, record.position());
+    EXPECT_EQ(40, record.end());
+    EXPECT_EQ(24, record.available());
+    EXPECT_EQ(0xAA, record.read<uint8_t>(8));
+
+    // The parent has moved on, the child is not affected
+    EXPECT_EQ(0x02, br.read<uint8_t>(8));
+    EXPECT_EQ(0xBBC, record.peek<uint16_t>(12));
+    EXPECT_EQ(0xBBCC, record.read<uint16_t>(16));
+    EXPECT_EQ(0, record.available());
+    EXPECT_THROW(record.read<uint8_t>(1), std::runtime_error);
+    EXPECT_THROW(record.skip(1), std::runtime_error);
+
+    EXPECT_THROW(record.seek(8), std::range_error);
+    EXPECT_THROW(record.seek(48), std::range_error);
+    record.seek(24);
+    EXPECT_EQ(0xBB, record.read<uint8_t>(8));
+
+    // Nested ranges cannot outgrow their parent
+    record.seek(16);
+    auto nested = record.subreader(16);
+    EXPECT_THROW(record.subreader(32), std::range_error);
+    EXPECT_EQ(0xAABB, nested.read<uint16_t>(16));
+    EXPECT_THROW(nested.read<uint8_t>(8), std::runtime_error);
+
+    EXPECT_EQ(0x02, br.read<uint8_t>(8));
+    EXPECT_EQ(0x1122, br.read<uint16_t>(16));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, subreader_scan)
+{
+    const uint8_t data[] = {0x10, 0x00, 0x00, 0x01, 0x20, 0x00, 0x00, 0x01};
+    const uint8_t start_code[] = {0x00, 0x00, 0x01};
+    auto source = std::make_shared<source_t>(data, sizeof(data));
+    bitreader<source_t> br(source);
+
+    br.skip(32);
+    auto tail = br.subreader(24);
+    EXPECT_FALSE(tail.find_bytes(start_code, sizeof(start_code)).has_value());
+    EXPECT_LE(tail.position(), tail.end());
+
+    auto found = br.find_bytes(start_code, sizeof(start_code));
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(40, *found);
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, subreader_streaming)
+{
+    const uint8_t head[] = {0xAB, 0xCD};
+
+    auto source = std::make_shared<stream_byte_source>();
+    source->push(head, sizeof(head));
+    bitreader<stream_byte_source> br(source);
+
+    auto child = br.subreader(24);
+    EXPECT_EQ(0xABCD, child.read<uint16_t>(16));
+
+    // Missing data inside the range may still arrive, past the range it cannot
+    EXPECT_THROW(child.read<uint8_t>(8), need_more_data);
+    try {
+        child.read<uint16_t>(16);
+        FAIL() << "Reading past the range must fail";
+    } catch (const need_more_data&) {
+        FAIL() << "Reading past the range must not wait for data";
+    } catch (const std::runtime_error&) {
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, subreader_parent_skips_first)
+{
+    // The parent moves past the record before it is read, on a source
+    // that drops consumed data
+    auto source = std::make_shared<stream_byte_source>();
+    for (size_t chunk = 0; chunk < 10; ++chunk) {
+        uint8_t data[100];
+        for (size_t iter = 0; iter < sizeof(data); ++iter) {
+            data[iter] = static_cast<uint8_t>(chunk * 100 + iter);
+        }
+        source->push(data, sizeof(data));
+    }
+    bitreader<stream_byte_source> br(source);
+
+    EXPECT_EQ(0, br.read<uint8_t>(8));
+    auto record = br.subreader(800 * 8);
+    br.skip(800 * 8);
+    EXPECT_EQ(static_cast<uint8_t>(801), br.read<uint8_t>(8));
+    EXPECT_THROW(br.seek(8), std::range_error);
+
+    for (size_t iter = 1; iter <= 800; ++iter) {
+        ASSERT_EQ(static_cast<uint8_t>(iter), record.read<uint8_t>(8));
+    }
+    EXPECT_EQ(0, record.available());
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderTest, subreader_movable)
+{
+    const uint8_t data[] = {0x01, 0x02, 0x03, 0x04};
+    auto source = std::make_shared<source_t>(data, sizeof(data));
+    bitreader<source_t> br(source);
+
+    std::vector<bitreader<source_t>> records;
+    for (size_t iter = 0; iter < sizeof(data); ++iter) {
+        records.push_back(br.subreader(8));
+        br.skip(8);
+    }
+
+    auto last = std::move(records.back());
+    EXPECT_EQ(0x04, last.read<uint8_t>(8));
+    for (size_t iter = 0; iter + 1 < records.size(); ++iter) {
+        EXPECT_EQ(iter + 1, records[iter].read<uint8_t>(8));
+    }
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/memory_byte_source.hpp"
+#include "bitreader/data_source/segmented_byte_source.hpp"
+#include "bitreader/data_source/stream_byte_source.hpp"
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    std::shared_ptr<memory_byte_source> make_source(
+            const std::vector<uint8_t>& data,
+            memory_byte_source*)
+    {
+        return std::make_shared<memory_byte_source>(data.data(), data.size());
+    }
+
+    //--------------------------------------------------------------------------
+    std::shared_ptr<segmented_byte_source> make_source(
+            const std::vector<uint8_t>& data,
+            segmented_byte_source*)
+    {
+        // Odd segment sizes so that matches straddle segments and chunks
+        std::vector<shared_buffer> segments;
+        for (size_t offset = 0; offset < data.size(); offset += 1001) {
+            auto size = std::min<size_t>(1001, data.size() - offset);
+            segments.push_back(shared_buffer::copy_mem(data.data() + offset, size));
+        }
+        return std::make_shared<segmented_byte_source>(std::move(segments));
+    }
+
+    //--------------------------------------------------------------------------
+    std::vector<uint8_t> noise(size_t size)
+    {
+        // No zero bytes, no 0x47 and no run of set bits longer than 7
+        std::vector<uint8_t> ret(size);
+        for (size_t iter = 0; iter < size; ++iter) {
+            ret[iter] = static_cast<uint8_t>(0x10 + iter % 0x30);
+        }
+        return ret;
+    }
+}
+
+//------------------------------------------------------------------------------
+template<typename Source>
+class bitreaderScanTest: public ::testing::Test
+{
+protected:
+    std::shared_ptr<Source> source(const std::vector<uint8_t>& data)
+    {
+        return make_source(data, static_cast<Source*>(nullptr));
+    }
+};
+
+using scan_sources = ::testing::Types<memory_byte_source, segmented_byte_source>;
+TYPED_TEST_SUITE(bitreaderScanTest, scan_sources);
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitreaderScanTest, startCodes)
+{
+    auto data = noise(20000);
+    const size_t codes[] = {3, 4094, 4097, 9000, 19997};
+    for (auto at: codes) {
+        data[at] = 0x00;
+        data[at + 1] = 0x00;
+        data[at + 2] = 0x01;
+    }
+
+    bitreader<TypeParam> br(this->source(data));
+    const uint8_t start_code[] = {0x00, 0x00, 0x01};
+    for (auto at: codes) {
+        auto found = br.find_bytes(start_code, sizeof(start_code));
+        ASSERT_TRUE(found.has_value());
+        EXPECT_EQ(at * 8, *found);
+        EXPECT_EQ(at * 8, br.position());
+        EXPECT_EQ(0x000001, br.template read<uint32_t>(24));
+    }
+
+    EXPECT_FALSE(br.find_bytes(start_code, sizeof(start_code)).has_value());
+    EXPECT_EQ(data.size() * 8, br.position());
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitreaderScanTest, startCodeFromUnalignedPosition)
+{
+    auto data = noise(64);
+    data[10] = 0x00;
+    data[11] = 0x00;
+    data[12] = 0x01;
+    data[20] = 0x00;
+    data[21] = 0x00;
+    data[22] = 0x01;
+
+    bitreader<TypeParam> br(this->source(data));
+    br.skip(10 * 8 + 3);
+
+    const uint8_t start_code[] = {0x00, 0x00, 0x01};
+    auto found = br.find_bytes(start_code, sizeof(start_code));
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(20 * 8, *found);
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitreaderScanTest, transportStreamSync)
+{
+    auto data = noise(188 * 40 + 50);
+
+    // A stray sync byte first, then packets starting at offset 100
+    data[30] = 0x47;
+    for (size_t packet = 0; packet < 40; ++packet) {
+        data[100 + packet * 188] = 0x47;
+    }
+
+    bitreader<TypeParam> br(this->source(data));
+    auto found = br.find_sync(0x47, 188, 3);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(100 * 8, *found);
+
+    // The last two packets cannot be confirmed any more
+    br.skip(8);
+    found = br.find_sync(0x47, 188, 3);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ((100 + 188) * 8, *found);
+
+    br.seek((100 + 38 * 188) * 8);
+    EXPECT_FALSE(br.find_sync(0x47, 188, 3).has_value());
+    EXPECT_EQ((100 + 38 * 188) * 8, br.position());
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitreaderScanTest, bitAlignedSyncWord)
+{
+    auto data = noise(10000);
+
+    // 0xFFF at bit offsets 8*5000+3 and 8*8000+6
+    data[5000] = 0x1F;
+    data[5001] = 0xFE;
+    data[8000] = 0x03;
+    data[8001] = 0xFF;
+    data[8002] = 0xC0;
+
+    bitreader<TypeParam> br(this->source(data));
+    auto found = br.find_bits(0xFFF, 12);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(5000 * 8 + 3, *found);
+    EXPECT_EQ(0xFFF, br.template read<uint32_t>(12));
+
+    found = br.find_bits(0xFFF, 12);
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(8000 * 8 + 6, *found);
+
+    // Starting mid-word must not report the word itself
+    br.skip(1);
+    EXPECT_FALSE(br.find_bits(0xFFF, 12).has_value());
+
+    EXPECT_ANY_THROW(br.find_bits(0, 0));
+    EXPECT_ANY_THROW(br.find_bits(0, 57));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitreaderScanTest, streamingResume)
+{
+    auto source = std::make_shared<stream_byte_source>();
+    const uint8_t head[] = {0x11, 0x22, 0x00, 0x00};
+    source->push(head, sizeof(head));
+
+    bitreader<stream_byte_source> br(source);
+    const uint8_t start_code[] = {0x00, 0x00, 0x01};
+    EXPECT_FALSE(br.find_bytes(start_code, sizeof(start_code)).has_value());
+    EXPECT_EQ(16, br.position());
+
+    const uint8_t tail[] = {0x01, 0x65};
+    source->push(tail, sizeof(tail));
+    source->finish();
+
+    auto found = br.find_bytes(start_code, sizeof(start_code));
+    ASSERT_TRUE(found.has_value());
+    EXPECT_EQ(16, *found);
+    EXPECT_EQ(0x00000165, br.read<uint32_t>(32));
+}
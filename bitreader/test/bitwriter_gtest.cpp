@@ -27,10 +27,57 @@ namespace {
             return _data;
         }
 
+        void merge_at(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size)
+        {
+            merge_bytes(_data.data() + position, data, mask, size);
+        }
+
     private:
         std::vector<uint8_t> _data;
     };
 
+    //--------------------------------------------------------------------------
+    class TestWindowSink: public TestWriterSink
+    {
+    public:
+        uint8_t* window(size_t bytes)
+        {
+            _window.resize(_committed + bytes);
+            return _window.data() + _committed;
+        }
+
+        void commit(size_t bytes)
+        {
+            _committed += bytes;
+            ++_commits;
+        }
+
+        size_t position() const
+        {
+            return _committed;
+        }
+
+        std::vector<uint8_t> data() const
+        {
+            return {_window.begin(), _window.begin() + static_cast<ptrdiff_t>(_committed)};
+        }
+
+        size_t commits() const
+        {
+            return _commits;
+        }
+
+        void merge_at(uint64_t position, const uint8_t* data, const uint8_t* mask, size_t size)
+        {
+            merge_bytes(_window.data() + position, data, mask, size);
+        }
+
+    private:
+        std::vector<uint8_t> _window;
+        size_t _committed = 0;
+        size_t _commits = 0;
+    };
+
     using bytes = std::vector<uint8_t>;
 }
 
@@ -221,3 +268,257 @@ TEST(bitwriterTest, TestExpGolombK0)
     w.flush();
     EXPECT_EQ(bytes({0b00011011}), sink->data());
 }
+
+//------------------------------------------------------------------------------
+TEST(bitwriterTest, WordWrites)
+{
+    auto sink = std::make_shared<TestWindowSink>();
+    bitwriter w(sink);
+    static_assert(decltype(w)::word_writes);
+
+    w.write(6, 4);
+    w.write(0x112234, 24);
+    EXPECT_EQ(28, w.position());
+    EXPECT_EQ(0, sink->position());
+
+    w.flush();
+    EXPECT_EQ(32, w.position());
+    EXPECT_EQ(bytes({0x61, 0x12, 0x23, 0x40}), sink->data());
+}
+
+//------------------------------------------------------------------------------
+TEST(bitwriterTest, WordWritesAcrossWords)
+{
+    auto sink = std::make_shared<TestWindowSink>();
+    bitwriter w(sink);
+
+    w.write(0b101, 3);
+    w.write(0xFEDCBA9876543210ull, 64);
+    w.write(0x1234u, 16);
+    w.write(uint64_t(0), 0);
+    EXPECT_EQ(83, w.position());
+    EXPECT_EQ(1, sink->commits());
+
+    w.flush();
+    EXPECT_EQ(bytes({0xBF, 0xDB, 0x97, 0x53, 0x0E, 0xCA, 0x86, 0x42,
+                     0x02, 0x46, 0x80}), sink->data());
+    EXPECT_ANY_THROW(w.write(1u, 33));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitwriterTest, WordWritesOneStorePerWord)
+{
+    auto sink = std::make_shared<TestWindowSink>();
+    bitwriter w(sink);
+
+    for (uint32_t iter = 0; iter < 100; ++iter) {
+        w.write(iter, 32);
+    }
+    EXPECT_EQ(50, sink->commits());
+    EXPECT_EQ(400, sink->position());
+    auto data = sink->data();
+    EXPECT_EQ(bytes({0, 0, 0, 99}), bytes(data.end() - 4, data.end()));
+}
+
+//------------------------------------------------------------------------------
+TEST(bitwriterTest, WordWritesSkipAndAlign)
+{
+    auto sink = std::make_shared<TestWindowSink>();
+    bitwriter w(sink);
+
+    w.write(6, 4);
+    w.skip(13);
+    w.write(0b111, 3);
+    EXPECT_EQ(20, w.position());
+    w.align(8);
+    EXPECT_EQ(24, w.position());
+    w.skip(100);
+    w.write(1, 1);
+    w.flush();
+    EXPECT_EQ(128, w.position());
+
+    auto data = sink->data();
+    ASSERT_EQ(16, data.size());
+    EXPECT_EQ(bytes({0x60, 0x00, 0x70}), bytes(data.begin(), data.begin() + 3));
+    EXPECT_EQ(0x08, data[15]);
+}
+
+//------------------------------------------------------------------------------
+TEST(bitwriterTest, WordWritesCodecs)
+{
+    auto sink = std::make_shared<TestWindowSink>();
+    bitwriter w{sink};
+
+    w.write<ext::string_nullterm>("test");
+    w.write<ext::exp_golomb_k0<uint8_t>>(0b1101);
+    w.flush();
+    EXPECT_EQ(bytes({'t', 'e', 's', 't', '\0', 0b00011010}), sink->data());
+}
+
+//------------------------------------------------------------------------------
+template<typename Sink>
+class bitwriterBulkTest: public ::testing::Test {};
+
+using bulk_sinks = ::testing::Types<TestWriterSink, TestWindowSink>;
+TYPED_TEST_SUITE(bitwriterBulkTest, bulk_sinks);
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitwriterBulkTest, WriteN)
+{
+    std::vector<uint32_t> values;
+    for (uint32_t iter = 0; iter < 50000; ++iter) {
+        values.push_back(iter * 2654435761u);
+    }
+
+    for (size_t offset: {0u, 3u, 8u}) {
+        for (size_t bits: {1u, 7u, 13u, 24u, 32u}) {
+            auto bulk = std::make_shared<TypeParam>();
+            auto single = std::make_shared<TypeParam>();
+            bitwriter wb(bulk);
+            bitwriter ws(single);
+
+            wb.write(0x5A, offset);
+            ws.write(0x5A, offset);
+            wb.write_n(std::span<const uint32_t>(values), bits);
+            for (auto value: values) {
+                ws.write(value & ((uint64_t(1) << bits) - 1), bits);
+            }
+            EXPECT_EQ(ws.position(), wb.position());
+
+            wb.flush();
+            ws.flush();
+            EXPECT_EQ(single->data(), bulk->data()) << "offset " << offset << ", bits " << bits;
+        }
+    }
+
+    auto sink = std::make_shared<TypeParam>();
+    bitwriter w(sink);
+    EXPECT_ANY_THROW(w.write_n(std::span<const uint32_t>(values), 33));
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitwriterBulkTest, WriteNNarrow)
+{
+    std::vector<uint8_t> bytes_in;
+    std::vector<int16_t> shorts;
+    for (uint32_t iter = 0; iter < 5003; ++iter) {
+        bytes_in.push_back(static_cast<uint8_t>(iter * 37 + 11));
+        shorts.push_back(static_cast<int16_t>(iter * 40503u));
+    }
+
+    for (size_t offset: {0u, 5u}) {
+        for (size_t bits: {1u, 3u, 8u, 11u, 16u}) {
+            auto bulk = std::make_shared<TypeParam>();
+            auto single = std::make_shared<TypeParam>();
+            bitwriter wb(bulk);
+            bitwriter ws(single);
+
+            wb.write(0x15, offset);
+            ws.write(0x15, offset);
+            if (bits <= 8) {
+                wb.write_n(std::span<const uint8_t>(bytes_in), bits);
+                for (auto value: bytes_in) {
+                    ws.write(value & ((1u << bits) - 1), bits);
+                }
+            }
+            wb.write_n(std::span<const int16_t>(shorts), bits);
+            for (auto value: shorts) {
+                ws.write(static_cast<uint16_t>(value) & ((1u << bits) - 1), bits);
+            }
+            EXPECT_EQ(ws.position(), wb.position());
+
+            wb.flush();
+            ws.flush();
+            EXPECT_EQ(single->data(), bulk->data()) << "offset " << offset << ", bits " << bits;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitwriterBulkTest, WriteNWide)
+{
+    const std::vector<uint16_t> shorts = {0x0102, 0x0304};
+    const std::vector<uint64_t> longs = {0x1122334455667788ull};
+
+    auto sink = std::make_shared<TypeParam>();
+    bitwriter w(sink);
+    w.write_n(std::span<const uint16_t>(shorts), 16);
+    w.write_n(std::span<const uint64_t>(longs), 64);
+    w.flush();
+    EXPECT_EQ(bytes({1, 2, 3, 4, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88}), sink->data());
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitwriterBulkTest, WriteBytes)
+{
+    bytes payload(200000);
+    for (size_t iter = 0; iter < payload.size(); ++iter) {
+        payload[iter] = static_cast<uint8_t>(iter * 31 + 7);
+    }
+
+    for (size_t offset: {0u, 4u, 16u}) {
+        for (size_t size: {0u, 5u, 8u, 13u, 200000u}) {
+            auto bulk = std::make_shared<TypeParam>();
+            auto single = std::make_shared<TypeParam>();
+            bitwriter wb(bulk);
+            bitwriter ws(single);
+
+            wb.write(0xABCD, offset);
+            ws.write(0xABCD, offset);
+            wb.write_bytes(std::span<const uint8_t>(payload.data(), size));
+            for (size_t iter = 0; iter < size; ++iter) {
+                ws.write(payload[iter], 8);
+            }
+            wb.write(1, 1);
+            ws.write(1, 1);
+            EXPECT_EQ(ws.position(), wb.position());
+
+            wb.flush();
+            ws.flush();
+            EXPECT_EQ(single->data(), bulk->data()) << "offset " << offset << ", size " << size;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TYPED_TEST(bitwriterBulkTest, ReserveAndPatch)
+{
+    for (size_t offset: {0u, 3u, 8u, 61u}) {
+        for (size_t bits: {1u, 5u, 12u, 32u, 64u}) {
+            for (size_t after: {0u, 2u, 40u, 1000u}) {
+                auto patched = std::make_shared<TypeParam>();
+                auto direct = std::make_shared<TypeParam>();
+                bitwriter wp(patched);
+                bitwriter wd(direct);
+                const uint64_t value = 0xF0E1D2C3B4A59687ull & ((bits < 64 ? uint64_t(1) << bits : 0) - 1);
+
+                // Ones all around, so any bit patched too many shows up
+                wp.write(~0ull, offset);
+                wd.write(~0ull, offset);
+                auto field = wp.reserve(bits);
+                wd.write(value, bits);
+                EXPECT_EQ(offset, field.position);
+                EXPECT_EQ(wd.position(), wp.position());
+
+                for (size_t iter = 0; iter < after; ++iter) {
+                    wp.write(1, 1);
+                    wd.write(1, 1);
+                }
+                wp.patch(field, value);
+
+                wp.write(0x3, 2);
+                wd.write(0x3, 2);
+                wp.flush();
+                wd.flush();
+                EXPECT_EQ(direct->data(), patched->data())
+                    << "offset " << offset << ", bits " << bits << ", after " << after;
+            }
+        }
+    }
+
+    auto sink = std::make_shared<TypeParam>();
+    bitwriter w(sink);
+    EXPECT_ANY_THROW(w.reserve(65));
+    using field_type = typename bitwriter<TypeParam>::reserved_field;
+    EXPECT_THROW(w.patch(field_type{0, 8}, 1), std::range_error);
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "bitreader/common/block_cache.hpp"
+#include "bitreader/common/cached_file_reader.hpp"
+#include "bitreader/data_source/file_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+TEST(blockCacheTest, hitAndMiss)
+{
+    auto reader = std::make_shared<fake_file_reader>(1000);
+    block_cache cache(256, 1024);
+    auto file = cache.register_file();
+
+    auto block = cache.get(file, 1, *reader);
+    EXPECT_EQ(256, block.size());
+    EXPECT_EQ(257 & 0xFF, block[0]);
+    EXPECT_EQ(block.get(), cache.get(file, 1, *reader).get());
+
+    auto tail = cache.get(file, 3, *reader);
+    EXPECT_EQ(1000 - 3*256, tail.size());
+
+    auto stats = cache.stats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(2, stats.misses);
+    EXPECT_EQ(2, reader->reads());
+    EXPECT_EQ(512, stats.memory);
+}
+
+//------------------------------------------------------------------------------
+TEST(blockCacheTest, evictsLeastRecentlyUsed)
+{
+    auto reader = std::make_shared<fake_file_reader>(1000);
+    block_cache cache(256, 512);
+    auto file = cache.register_file();
+
+    cache.get(file, 0, *reader);
+    cache.get(file, 1, *reader);
+    cache.get(file, 0, *reader);
+    cache.get(file, 2, *reader);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(1, stats.evictions);
+    EXPECT_EQ(512, stats.memory);
+
+    cache.get(file, 0, *reader);
+    EXPECT_EQ(2, cache.stats().hits);
+    cache.get(file, 1, *reader);
+    EXPECT_EQ(4, cache.stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(blockCacheTest, filesAreSeparate)
+{
+    auto reader1 = std::make_shared<fake_file_reader>(100);
+    auto reader2 = std::make_shared<fake_file_reader>(50);
+    block_cache cache(256, 1024);
+
+    auto block1 = cache.get(cache.register_file(), 0, *reader1);
+    auto block2 = cache.get(cache.register_file(), 0, *reader2);
+    EXPECT_EQ(100, block1.size());
+    EXPECT_EQ(50, block2.size());
+    EXPECT_EQ(2, cache.stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(blockCacheTest, sharedBetweenSources)
+{
+    const size_t size = 100000;
+    auto data = std::make_shared<fake_file_reader>(size);
+    auto cache = std::make_shared<block_cache>(4096, 1024 * 1024);
+    auto reader = cached_file_reader::wrap(data, cache);
+
+    file_byte_source src1(reader);
+    file_byte_source src2(reader);
+    uint64_t buf1 = 0;
+    uint64_t buf2 = 0;
+    src1.seek(5000);
+    src2.seek(5000);
+    EXPECT_EQ(8, src1.get_n(buf1, 8));
+    EXPECT_EQ(8, src2.get_n(buf2, 8));
+    EXPECT_EQ(buf1, buf2);
+
+    auto misses = cache->stats().misses;
+    EXPECT_GT(cache->stats().hits, 0);
+
+    auto clone = src1.clone();
+    clone->seek(5000);
+    uint64_t buf3 = 0;
+    EXPECT_EQ(8, clone->get_n(buf3, 8));
+    EXPECT_EQ(buf1, buf3);
+    EXPECT_EQ(misses, cache->stats().misses);
+
+    clone->seek(size - 2);
+    EXPECT_EQ(2, clone->get_n(buf3, 8));
+    EXPECT_EQ(((size - 1) & 0xFF) << 8 | (size & 0xFF), buf3 & 0xFFFF);
+}
+
+//------------------------------------------------------------------------------
+TEST(blockCacheTest, sourcesBorrowBlocks)
+{
+    const size_t size = 100000;
+    auto data = std::make_shared<fake_file_reader>(size);
+    auto cache = std::make_shared<block_cache>(4096, 1024 * 1024);
+    auto reader = cached_file_reader::wrap(data, cache);
+
+    uint64_t start = 0;
+    auto block = reader->borrow(5000, start);
+    EXPECT_EQ(4096, start);
+    EXPECT_EQ(4096, block.size());
+    EXPECT_TRUE(block.is_slice());
+    EXPECT_EQ(reader->borrow(8191, start).get(), block.get());
+
+    // Both sources read the cached block itself, no window of their own
+    file_byte_source src1(reader);
+    file_byte_source src2(reader->clone());
+    for (auto src: {&src1, &src2}) {
+        uint64_t buf = 0;
+        src->seek(5000);
+        EXPECT_EQ(2, src->get_n(buf, 2));
+        EXPECT_EQ((5001 & 0xFF) << 8 | (5002 & 0xFF), buf);
+        EXPECT_EQ(4096, src->window_size());
+    }
+    EXPECT_EQ(4, block.use_count());
+
+    // A read across the end of a block falls back to a window of its own
+    uint64_t buf = 0;
+    src1.seek(8190);
+    EXPECT_EQ(4, src1.get_n(buf, 4));
+    EXPECT_EQ(0xFF000102, buf);
+    EXPECT_EQ(3, block.use_count());
+}
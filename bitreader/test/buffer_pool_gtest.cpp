@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include "bitreader/common/buffer_pool.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, acquire)
+{
+    buffer_pool pool(1024, 512, 2);
+    auto buf = pool.acquire();
+    EXPECT_TRUE(buf);
+    EXPECT_EQ(0, buf.size());
+    EXPECT_EQ(1024, buf.capacity());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % 512);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, reuse)
+{
+    buffer_pool pool(1024, 512, 2);
+    auto buf = pool.acquire();
+    buf.resize(10);
+    auto data = buf.get();
+    pool.release(buf);
+
+    auto again = pool.acquire();
+    EXPECT_EQ(data, again.get());
+    EXPECT_EQ(0, again.size());
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, limit)
+{
+    buffer_pool pool(1024, 512, 1);
+    auto buf1 = pool.acquire();
+    auto buf2 = pool.acquire();
+    auto data1 = buf1.get();
+    pool.release(buf1);
+    pool.release(buf2);
+
+    EXPECT_EQ(data1, pool.acquire().get());
+    EXPECT_NE(data1, pool.acquire().get());
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, foreignBuffer)
+{
+    buffer_pool pool(1024, 512, 1);
+    auto foreign = shared_buffer::allocate(16);
+    pool.release(foreign);
+    EXPECT_EQ(1024, pool.acquire().capacity());
+
+    // Matching size, alignment and resource, yet not from this pool
+    buffer_pool other(1024, 512, 1);
+    auto lookalike = shared_buffer::allocate(1024, 512);
+    auto data = lookalike.get();
+    auto stats = pool.stats();
+    pool.release(lookalike);
+    pool.release(other.acquire());
+    EXPECT_EQ(stats.in_use, pool.stats().in_use);
+    EXPECT_NE(data, pool.acquire().get());
+    EXPECT_EQ(stats.misses + 1, pool.stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, sizeClasses)
+{
+    buffer_pool pool(1024, 512, 2);
+    EXPECT_TRUE(pool.pooled(1024));
+    EXPECT_TRUE(pool.pooled(4096));
+    EXPECT_FALSE(pool.pooled(3000));
+    EXPECT_FALSE(pool.pooled(512));
+
+    auto big = pool.acquire(4096);
+    EXPECT_EQ(4096, big.capacity());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(big.get()) % 512);
+    auto data = big.get();
+    pool.release(std::move(big));
+
+    // Classes do not mix
+    EXPECT_NE(data, pool.acquire().get());
+    EXPECT_EQ(data, pool.acquire(4096).get());
+
+    auto odd = pool.acquire(3000);
+    EXPECT_EQ(3000, odd.capacity());
+    pool.release(std::move(odd));
+    auto misses = pool.stats().misses;
+    EXPECT_EQ(3000, pool.acquire(3000).capacity());
+    EXPECT_EQ(misses + 1, pool.stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, stats)
+{
+    buffer_pool pool(1024, 512, 2);
+    auto buf1 = pool.acquire();
+    auto buf2 = pool.acquire();
+    auto stats = pool.stats();
+    EXPECT_EQ(0, stats.hits);
+    EXPECT_EQ(2, stats.misses);
+    EXPECT_EQ(2, stats.in_use);
+    EXPECT_EQ(2, stats.high_water);
+
+    pool.release(std::move(buf1));
+    pool.release(std::move(buf2));
+    auto buf3 = pool.acquire();
+    stats = pool.stats();
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(2, stats.misses);
+    EXPECT_EQ(1, stats.in_use);
+    EXPECT_EQ(2, stats.high_water);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, threads)
+{
+    buffer_pool pool(1024, 512, 4);
+    std::vector<std::thread> threads;
+    for (size_t iter = 0; iter < 4; ++iter) {
+        threads.emplace_back([&pool] {
+            for (size_t round = 0; round < 1000; ++round) {
+                auto buf = pool.acquire(2048);
+                buf.resize(16);
+                buf.get()[0] = 1;
+                pool.release(std::move(buf));
+            }
+        });
+    }
+
+    for (auto& thread: threads) {
+        thread.join();
+    }
+
+    // Each thread allocates once, then keeps reusing its own buffer
+    auto stats = pool.stats();
+    EXPECT_EQ(4000, stats.hits + stats.misses);
+    EXPECT_LE(stats.misses, 4);
+    EXPECT_EQ(0, stats.in_use);
+    EXPECT_LE(stats.high_water, 4);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, outlivedByThreads)
+{
+    // Cached buffers go with the pool, while its resource still exists
+    {
+        std::pmr::unsynchronized_pool_resource resource;
+        buffer_pool pool(1024, 64, 4, &resource);
+        pool.release(pool.acquire());
+        pool.release(pool.acquire(2048));
+    }
+
+    buffer_pool other(1024, 64, 4);
+    auto buf = other.acquire();
+    other.release(std::move(buf));
+    EXPECT_EQ(1, other.stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(bufferPoolTest, twoPoolsOneThread)
+{
+    // A thread going back and forth between pools keeps its cached buffers
+    buffer_pool first(1024, 64, 4);
+    buffer_pool second(4096, 64, 4);
+    for (size_t round = 0; round < 10; ++round) {
+        first.release(first.acquire());
+        second.release(second.acquire());
+    }
+
+    EXPECT_EQ(1, first.stats().misses);
+    EXPECT_EQ(1, second.stats().misses);
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+#include "bitreader/common/byte_scan.hpp"
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    const uint8_t* naive_find(
+            const uint8_t* begin,
+            const uint8_t* end,
+            const uint8_t* pattern,
+            size_t size)
+    {
+        for (auto current = begin; current + size <= end; ++current) {
+            if (std::memcmp(current, pattern, size) == 0) {
+                return current;
+            }
+        }
+        return end;
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(byteScanTest, trivial)
+{
+    const uint8_t data[] = {1, 2, 3};
+    const uint8_t pattern[] = {2, 3, 4};
+
+    EXPECT_EQ(data, find_bytes(data, data + 3, pattern, 0));
+    EXPECT_EQ(data + 1, find_bytes(data, data + 3, pattern, 1));
+    EXPECT_EQ(data + 1, find_bytes(data, data + 3, pattern, 2));
+    EXPECT_EQ(data + 3, find_bytes(data, data + 3, pattern, 3));
+    EXPECT_EQ(data + 1, find_bytes(data + 1, data + 1, pattern, 0));
+    EXPECT_EQ(data + 1, find_bytes(data + 1, data + 1, pattern, 2));
+}
+
+//------------------------------------------------------------------------------
+TEST(byteScanTest, everyOffset)
+{
+    // Put the pattern at every offset, including ones that straddle the
+    // vector width and the scalar tail
+    const uint8_t pattern[] = {0x00, 0x00, 0x03};
+    for (size_t size = 3; size < 80; ++size) {
+        for (size_t at = 0; at + 3 <= size; ++at) {
+            std::vector<uint8_t> data(size, 0x00);
+            std::memcpy(data.data() + at, pattern, 3);
+
+            auto begin = data.data();
+            auto end = begin + size;
+            EXPECT_EQ(begin + at, find_bytes(begin, end, pattern, 3))
+                    << "size " << size << " at " << at;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(byteScanTest, matchesNaiveSearch)
+{
+    // Candidates with the right first and last bytes but a wrong middle
+    std::vector<uint8_t> data(1000);
+    for (size_t iter = 0; iter < data.size(); ++iter) {
+        data[iter] = static_cast<uint8_t>((iter * 7) % 5);
+    }
+
+    const uint8_t patterns[][4] = {
+        {0, 2, 4, 1},
+        {0, 0, 0, 1},
+        {4, 1, 3, 0},
+        {3, 3, 3, 3}
+    };
+
+    auto begin = data.data();
+    auto end = begin + data.size();
+    for (auto& pattern : patterns) {
+        for (size_t size = 1; size <= 4; ++size) {
+            for (size_t from = 0; from < 40; ++from) {
+                EXPECT_EQ(naive_find(begin + from, end, pattern, size),
+                          find_bytes(begin + from, end, pattern, size));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(byteScanTest, packMatchesShifts)
+{
+    std::vector<uint8_t> values(1003);
+    for (size_t iter = 0; iter < values.size(); ++iter) {
+        values[iter] = static_cast<uint8_t>(iter * 131 + 17);
+    }
+
+    for (size_t width: {1u, 2u, 4u}) {
+        const size_t count = values.size() / width;
+        const size_t per_word = 8 / width;
+        for (size_t bits = 1; bits <= width * 8; ++bits) {
+            std::vector<uint64_t> words(count / per_word);
+            ASSERT_EQ(words.size(), pack_bits(values.data(), count, width, bits, words.data()));
+
+            const uint64_t mask = (uint64_t(1) << bits) - 1;
+            for (size_t word = 0; word < words.size(); ++word) {
+                uint64_t expected = 0;
+                for (size_t iter = 0; iter < per_word; ++iter) {
+                    uint64_t value = 0;
+                    std::memcpy(&value, values.data() + (word * per_word + iter) * width, width);
+                    expected = (expected << bits) | (value & mask);
+                }
+                EXPECT_EQ(expected, words[word]) << "width " << width << ", bits " << bits;
+            }
+        }
+    }
+
+    uint64_t word;
+    EXPECT_ANY_THROW(pack_bits(values.data(), 8, 3, 8, &word));
+    EXPECT_ANY_THROW(pack_bits(values.data(), 8, 1, 9, &word));
+    EXPECT_ANY_THROW(pack_bits(values.data(), 8, 1, 0, &word));
+}
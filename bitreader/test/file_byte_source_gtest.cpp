@@ -1,9 +1,33 @@
 #include <gtest/gtest.h>
+#include <bitreader/bitreader.hpp>
 #include <bitreader/data_source/file_byte_source.hpp>
 #include "gtest_common.hpp"
 
 using namespace brcpp;
 
+//------------------------------------------------------------------------------
+namespace {
+    class cloning_file_reader: public fake_file_reader
+    {
+    public:
+        using fake_file_reader::fake_file_reader;
+
+        std::shared_ptr<file_reader> clone() override
+        {
+            ++_clones;
+            return fake_file_reader::clone();
+        }
+
+        size_t clones() const
+        {
+            return _clones;
+        }
+
+    private:
+        size_t _clones = 0;
+    };
+}
+
 //------------------------------------------------------------------------------
 template<typename Source>
 void check_get(Source& src, uint64_t val, size_t read)
@@ -128,3 +152,239 @@ TEST(fileByteSourceTest, clone)
     EXPECT_EQ(buf1, buf2);
 }
 
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, alignedReader)
+{
+    const size_t size = 20000;
+    const size_t alignment = 512;
+    auto data = std::make_shared<fake_file_reader>(size, alignment);
+    file_byte_source src(data);
+
+    EXPECT_NO_THROW(src.seek(1000));
+    check_get(src, (1000+1) & 0xFF, 1);
+    EXPECT_NO_THROW(src.seek(777));
+    check_get(src, (777+1) & 0xFF, 1);
+    EXPECT_NO_THROW(src.seek(size-3));
+    uint64_t buf = 0;
+    EXPECT_EQ(3, src.get_n(buf, 8));
+    EXPECT_EQ(0, src.available());
+
+    EXPECT_NO_THROW(src.seek(3));
+    auto clone = src.clone();
+    uint64_t buf1 = 0;
+    uint64_t buf2 = 0;
+    EXPECT_EQ(8, src.get_n(buf1, 8));
+    EXPECT_EQ(8, clone->get_n(buf2, 8));
+    EXPECT_EQ(0x0405060708090A0B, buf1);
+    EXPECT_EQ(buf1, buf2);
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, seekInsideWindow)
+{
+    const size_t size = 1000;
+    auto data = std::make_shared<fake_file_reader>(size);
+    file_byte_source src(data);
+
+    check_get(src, 1, 1);
+    EXPECT_EQ(1, data->reads());
+    src.seek(500);
+    check_get(src, 501 & 0xFF, 1);
+    src.seek(498);
+    check_get(src, 499 & 0xFF, 1);
+    src.seek(size-1);
+    check_get(src, size & 0xFF, 1);
+    EXPECT_EQ(1, data->reads());
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, sequentialGrowsWindow)
+{
+    const size_t size = 4 * 1024 * 1024;
+    auto data = std::make_shared<fake_file_reader>(size);
+    file_byte_source src(data);
+
+    auto initial = src.window_size();
+    uint64_t buf = 0;
+    while (src.available() > 0) {
+        src.get_n(buf, 8);
+    }
+
+    EXPECT_EQ(access_pattern::sequential, src.pattern());
+    EXPECT_EQ(file_byte_source::MaxWindowSize, src.window_size());
+    EXPECT_GT(src.window_size(), initial);
+    EXPECT_LT(data->reads(), size / initial);
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, stridedAndRandom)
+{
+    const size_t size = 4 * 1024 * 1024;
+    auto data = std::make_shared<fake_file_reader>(size);
+    file_byte_source src(data);
+    uint64_t buf = 0;
+
+    for (uint64_t pos = 0; pos < size; pos += 100000) {
+        src.seek(pos);
+        src.get_n(buf, 4);
+    }
+    EXPECT_EQ(access_pattern::strided, src.pattern());
+    EXPECT_EQ(file_byte_source::MinWindowSize, src.window_size());
+
+    const uint64_t positions[] = {3000000, 100, 2000000, 50000, 4000000};
+    for (auto pos: positions) {
+        src.seek(pos);
+        src.get_n(buf, 4);
+    }
+    EXPECT_EQ(access_pattern::random, src.pattern());
+    EXPECT_EQ(file_byte_source::MinWindowSize, src.window_size());
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, backwardKeepsLookBehind)
+{
+    const size_t size = 1024 * 1024;
+    auto data = std::make_shared<fake_file_reader>(size);
+    file_byte_source src(data);
+
+    src.seek(500000);
+    check_get(src, 500001 & 0xFF, 1);
+    auto reads = data->reads();
+
+    src.seek(499990);
+    check_get(src, 499991 & 0xFF, 1);
+    EXPECT_EQ(reads + 1, data->reads());
+
+    src.seek(499980);
+    check_get(src, 499981 & 0xFF, 1);
+    src.seek(500010);
+    check_get(src, 500011 & 0xFF, 1);
+    EXPECT_EQ(reads + 1, data->reads());
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, backwardCoversRead)
+{
+    const size_t size = 1024 * 1024;
+    const size_t alignment = 4096;
+    auto data = std::make_shared<fake_file_reader>(size, alignment);
+    file_byte_source src(data, 2 * alignment, file_byte_source::MaxWindowSize);
+    uint64_t buf = 0;
+
+    // Shrink the window to two blocks, then step back to the end of a block
+    for (uint64_t pos = 0; pos < size / 2; pos += 50000) {
+        src.seek(pos);
+        src.get_n(buf, 1);
+    }
+    ASSERT_EQ(2 * alignment, src.window_size());
+
+    const uint64_t pos = alignment * 100 + alignment - 1;
+    src.seek(pos);
+    buf = 0;
+    EXPECT_EQ(8, src.get_n(buf, 8));
+    uint64_t expected = 0;
+    for (uint64_t iter = 1; iter <= 8; ++iter) {
+        expected = (expected << 8) | ((pos + iter) & 0xFF);
+    }
+    EXPECT_EQ(expected, buf);
+    EXPECT_EQ(pos + 8, src.position());
+
+    EXPECT_THROW(file_byte_source(data, 1, 1024), std::invalid_argument);
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, memoryResource)
+{
+    const size_t size = 100000;
+    auto data = std::make_shared<fake_file_reader>(size);
+    counting_resource resource;
+    {
+        file_byte_source src(data, file_byte_source::MinWindowSize,
+                             file_byte_source::MaxWindowSize, &resource);
+        check_get(src, 0x01020304, 4);
+        EXPECT_EQ(1, resource.allocations());
+        EXPECT_EQ(file_byte_source::WindowAlignment, resource.last_alignment());
+
+        // The clone allocates from the same resource once it leaves the
+        // shared window
+        auto clone = src.clone();
+        EXPECT_EQ(1, resource.allocations());
+        clone->seek(50000);
+        check_get(*clone, (50000+1) & 0xFF, 1);
+        EXPECT_EQ(2, resource.allocations());
+    }
+    EXPECT_EQ(0, resource.live());
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, pooledWindows)
+{
+    const size_t size = 100000;
+    auto data = std::make_shared<fake_file_reader>(size);
+    auto pool = std::make_shared<buffer_pool>(
+            file_byte_source::MinWindowSize,
+            file_byte_source::PoolAlignment,
+            4);
+
+    {
+        file_byte_source src(data, file_byte_source::MinWindowSize,
+                             file_byte_source::MaxWindowSize, pool);
+        check_get(src, 0x01020304, 4);
+        EXPECT_EQ(1, pool->stats().in_use);
+
+        // The clone shares the window until it needs another one, and
+        // does not even borrow one from the pool meanwhile
+        auto before = pool->stats();
+        auto clone = src.clone();
+        check_get(*clone, 0x05060708, 4);
+        EXPECT_EQ(1, pool->stats().in_use);
+        EXPECT_EQ(before.hits, pool->stats().hits);
+        EXPECT_EQ(before.misses, pool->stats().misses);
+
+        clone->seek(50000);
+        check_get(*clone, (50000+1) & 0xFF, 1);
+        EXPECT_EQ(2, pool->stats().in_use);
+        check_get(src, 0x05060708, 4);
+    }
+
+    auto stats = pool->stats();
+    EXPECT_EQ(0, stats.in_use);
+    EXPECT_EQ(2, stats.high_water);
+
+    // The next source reuses a returned window
+    file_byte_source src(data, file_byte_source::MinWindowSize,
+                         file_byte_source::MaxWindowSize, pool);
+    check_get(src, 0x01, 1);
+    EXPECT_EQ(stats.hits + 1, pool->stats().hits);
+    EXPECT_EQ(stats.misses, pool->stats().misses);
+}
+
+//------------------------------------------------------------------------------
+TEST(fileByteSourceTest, subreaderSharesSource)
+{
+    const size_t size = 200000;
+    auto data = std::make_shared<cloning_file_reader>(size);
+    auto src = std::make_shared<file_byte_source>(data);
+    bitreader<file_byte_source> br(src);
+
+    // Boxes of 100 bytes, read in turns with the parent far ahead
+    br.skip(8 * 1000);
+    auto first = br.subreader(8 * 100);
+    br.skip(8 * 100);
+    auto second = br.subreader(8 * 100);
+    br.skip(8 * 150000);
+
+    for (size_t iter = 0; iter < 100; ++iter) {
+        ASSERT_EQ(static_cast<uint8_t>(1001 + iter), first.read<uint8_t>(8));
+        ASSERT_EQ(static_cast<uint8_t>(1101 + iter), second.read<uint8_t>(8));
+        ASSERT_EQ(static_cast<uint8_t>(151101 + iter), br.read<uint8_t>(8));
+    }
+
+    EXPECT_EQ(0, first.available());
+    EXPECT_EQ(8 * 1100, first.position());
+    EXPECT_EQ(0, data->clones());
+
+    // Switching between the readers must not reload the window each time
+    EXPECT_EQ(2, data->reads());
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "bitreader/bitwriter.hpp"
+#include "bitreader/data_sink/file_sink.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+namespace {
+    //--------------------------------------------------------------------------
+    class fileSinkTest: public ::testing::Test
+    {
+    protected:
+        void TearDown() override
+        {
+            std::remove(_path.c_str());
+        }
+
+        std::vector<uint8_t> contents() const
+        {
+            std::ifstream file(_path, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        std::string _path = temp_path("file_sink_gtest");
+    };
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, put)
+{
+    file_sink sink(_path, sync_policy::none, 1000, 2);
+    std::vector<uint8_t> expected;
+    for (size_t iter = 0; iter < 10000; ++iter) {
+        auto value = static_cast<uint8_t>(iter * 7);
+        sink.put(value, 8);
+        expected.push_back(value);
+    }
+
+    EXPECT_EQ(10000, sink.position());
+    sink.close();
+    EXPECT_EQ(expected, contents());
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, bitwriter)
+{
+    auto sink = std::make_shared<file_sink>(_path, sync_policy::on_close, 4096);
+    bitwriter w(sink);
+    static_assert(decltype(w)::word_writes);
+
+    for (uint32_t iter = 0; iter < 10000; ++iter) {
+        w.write(iter, 17);
+    }
+    w.flush();
+    sink->close();
+
+    auto data = contents();
+    ASSERT_EQ((10000 * 17 + 7) / 8, data.size());
+    EXPECT_EQ(0, data[2]);
+    EXPECT_EQ(0x40, data[4]);   // 1 ends at bit 33
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, writeAt)
+{
+    file_sink sink(_path, sync_policy::every_block, 100, 1);
+    for (size_t iter = 0; iter < 250; ++iter) {
+        sink.put(0, 8);
+    }
+
+    // Already written, queued, in the current block and across both
+    const uint8_t patch[] = {1, 2, 3, 4};
+    sink.write_at(10, patch, 4);
+    sink.write_at(210, patch, 4);
+    sink.write_at(198, patch, 4);
+    EXPECT_THROW(sink.write_at(248, patch, 4), std::range_error);
+
+    sink.sync();
+    sink.put(9, 8);
+    sink.close();
+
+    auto data = contents();
+    ASSERT_EQ(251, data.size());
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}), std::vector<uint8_t>(data.begin() + 10, data.begin() + 14));
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}), std::vector<uint8_t>(data.begin() + 198, data.begin() + 202));
+    EXPECT_EQ(std::vector<uint8_t>({1, 2, 3, 4}), std::vector<uint8_t>(data.begin() + 210, data.begin() + 214));
+    EXPECT_EQ(9, data[250]);
+
+    EXPECT_THROW(sink.put(1, 8), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, patch)
+{
+    auto sink = std::make_shared<file_sink>(_path, sync_policy::none, 64, 1);
+    bitwriter w(sink);
+    static_assert(patchable_byte_sink<file_sink>);
+
+    // A field in a block on disk, one queued and one still in memory
+    w.write(0x7, 3);
+    auto first = w.reserve(20);
+    for (size_t iter = 0; iter < 1000; ++iter) {
+        w.write(1, 1);
+    }
+    auto second = w.reserve(20);
+    w.write(~0u, 32);
+    w.patch(first, 0xABCDE);
+    w.patch(second, 0x12345);
+    w.flush();
+
+    const uint8_t data[] = {0x00};
+    const uint8_t mask[] = {0x0F};
+    sink->merge_at(5, data, mask, 1);
+    sink->close();
+
+    auto contents = this->contents();
+    ASSERT_EQ((3 + 20 + 1000 + 20 + 32 + 7) / 8, contents.size());
+    EXPECT_EQ(0xF5, contents[0]);   // 111 then 1010 1...
+    EXPECT_EQ(0x79, contents[1]);
+    EXPECT_EQ(0xBD, contents[2]);
+    EXPECT_EQ(0xF0, contents[5]);
+    // 1023 bits in, the second field starts with the last bit of byte 127
+    EXPECT_EQ(0xFE, contents[127]);
+    EXPECT_EQ(0x24, contents[128]);
+    EXPECT_EQ(0x68, contents[129]);
+    EXPECT_EQ(0xBF, contents[130]);
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, largeWindow)
+{
+    file_sink sink(_path, sync_policy::none, 16);
+    auto window = sink.window(1000);
+    for (size_t iter = 0; iter < 1000; ++iter) {
+        window[iter] = static_cast<uint8_t>(iter);
+    }
+    sink.commit(1000);
+    sink.close();
+
+    auto data = contents();
+    ASSERT_EQ(1000, data.size());
+    EXPECT_EQ(static_cast<uint8_t>(999), data[999]);
+}
+
+//------------------------------------------------------------------------------
+TEST_F(fileSinkTest, openFailure)
+{
+    EXPECT_THROW(file_sink("/nonexistent/dir/file.bin"), std::runtime_error);
+}
@@ -1,4 +1,8 @@
 #pragma once
+#include <filesystem>
+#include <memory_resource>
+#include <random>
+#include <string>
 #include "bitreader/common/file_reader.hpp"
 #include "bitreader/common/shared_buffer.hpp"
 
@@ -24,7 +28,8 @@ namespace {
     {
     public:
         //----------------------------------------------------------------------
-        explicit fake_file_reader(size_t size)
+        explicit fake_file_reader(size_t size, size_t alignment = 1)
+            : _alignment(alignment)
         {
             _data = shared_buffer::wrap_mem(
                 generate_test_data(size),
@@ -39,6 +44,14 @@ namespace {
                 throw std::runtime_error("Cannot seek beyond the end of the buffer");
             }
 
+            if (position % _alignment != 0 ||
+                bytes % _alignment != 0 ||
+                reinterpret_cast<uintptr_t>(dest) % _alignment != 0)
+            {
+                throw std::runtime_error("Misaligned read request");
+            }
+
+            ++_reads;
             size_t to_copy = std::min(_data.size() - position, bytes);
             auto begin = _data.begin() + position;
             auto end = begin + to_copy;
@@ -72,15 +85,87 @@ namespace {
             return true;
         }
 
+        //----------------------------------------------------------------------
+        size_t alignment() override
+        {
+            return _alignment;
+        }
+
+        //----------------------------------------------------------------------
+        void prefetch(uint64_t position, size_t bytes) override
+        {
+            ++_prefetches;
+        }
+
+        //----------------------------------------------------------------------
+        size_t reads() const
+        {
+            return _reads;
+        }
+
+        //----------------------------------------------------------------------
+        size_t prefetches() const
+        {
+            return _prefetches;
+        }
+
         //----------------------------------------------------------------------
         ~fake_file_reader() override = default;
 
     private:
         fake_file_reader(const fake_file_reader& other)
+            : _alignment(other._alignment)
         {
             _data = shared_buffer::clone(other._data);
         }
 
+        size_t _alignment;
+        size_t _reads = 0;
+        size_t _prefetches = 0;
         shared_buffer _data;
     };
+
+    //--------------------------------------------------------------------------
+    class counting_resource: public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations() const { return _allocations; }
+        size_t live() const { return _live; }
+        size_t last_alignment() const { return _last_alignment; }
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++_allocations;
+            ++_live;
+            _last_alignment = alignment;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override
+        {
+            --_live;
+            std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        size_t _allocations = 0;
+        size_t _live = 0;
+        size_t _last_alignment = 0;
+    };
+
+    //--------------------------------------------------------------------------
+    /**
+     * @brief Unique file name in the temp directory, so parallel runs do not collide
+     */
+    inline std::string temp_path(const std::string& name)
+    {
+        std::random_device random;
+        auto unique = name + "-" + std::to_string(random()) + ".bin";
+        return (std::filesystem::temp_directory_path() / unique).string();
+    }
 }
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "bitreader/common/huge_page_resource.hpp"
+#include "bitreader/common/shared_buffer.hpp"
+#include "bitreader/data_source/file_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+TEST(hugePageResourceTest, smallAllocationsGoUpstream)
+{
+    counting_resource upstream;
+    huge_page_resource resource(huge_page_resource::HugePageSize, &upstream);
+
+    auto buf = shared_buffer::allocate(4096, 64, &resource);
+    EXPECT_EQ(1, upstream.allocations());
+    EXPECT_EQ(0, resource.mapped());
+    buf = shared_buffer();
+    EXPECT_EQ(0, upstream.live());
+}
+
+//------------------------------------------------------------------------------
+TEST(hugePageResourceTest, largeAllocations)
+{
+    counting_resource upstream;
+    huge_page_resource resource(huge_page_resource::HugePageSize, &upstream);
+
+    const size_t size = 5 * 1024 * 1024;
+    {
+        auto buf = shared_buffer::allocate(size, 4096, &resource);
+        buf.resize(size);
+        std::memset(buf.get(), 0xA5, size);
+        EXPECT_EQ(0xA5, buf[size - 1]);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % 4096);
+
+#ifndef WIN32
+        EXPECT_EQ(0, upstream.allocations());
+        EXPECT_EQ(1, resource.mapped());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % huge_page_resource::HugePageSize);
+#endif
+    }
+    EXPECT_EQ(0, resource.mapped());
+    EXPECT_EQ(0, upstream.live());
+}
+
+#ifndef WIN32
+//------------------------------------------------------------------------------
+TEST(hugePageResourceTest, exactPages)
+{
+    counting_resource upstream;
+    huge_page_resource resource(huge_page_resource::HugePageSize, &upstream);
+
+    auto buf = shared_buffer::allocate(huge_page_resource::HugePageSize, 64, &resource);
+    EXPECT_EQ(1, resource.mapped());
+    EXPECT_EQ(huge_page_resource::HugePageSize, resource.mapped_bytes());
+    EXPECT_EQ(0, upstream.allocations());
+
+    buf = shared_buffer();
+    EXPECT_EQ(0, resource.mapped_bytes());
+}
+
+//------------------------------------------------------------------------------
+TEST(hugePageResourceTest, fileWindows)
+{
+    // With the defaults, sequential reading grows the window to a huge page
+    huge_page_resource resource;
+    const size_t size = 8 * 1024 * 1024;
+    auto data = std::make_shared<fake_file_reader>(size);
+    file_byte_source src(data, file_byte_source::MinWindowSize,
+                         file_byte_source::MaxWindowSize, &resource);
+
+    uint64_t buf = 0;
+    while (src.available() > 0) {
+        src.get_n(buf, 8);
+    }
+
+    EXPECT_EQ(file_byte_source::MaxWindowSize, src.window_size());
+    EXPECT_EQ(1, resource.mapped());
+    EXPECT_EQ(huge_page_resource::HugePageSize, resource.mapped_bytes());
+}
+#endif
@@ -0,0 +1,318 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/inflate_byte_source.hpp"
+#include "bitreader/data_source/memory_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+using inflate_source = inflate_byte_source<memory_byte_source>;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    std::shared_ptr<inflate_source> make_inflate(
+            const std::vector<uint8_t>& data,
+            inflate_source::format fmt = inflate_source::format::automatic)
+    {
+        auto mem = std::make_shared<memory_byte_source>(data.data(), data.size());
+        return std::make_shared<inflate_source>(mem, fmt);
+    }
+
+    //--------------------------------------------------------------------------
+    std::string inflate_all(inflate_source& src)
+    {
+        std::string ret;
+        while (src.available() > 0) {
+            uint64_t buf = 0;
+            auto got = src.get_n(buf, 1);
+            EXPECT_EQ(1, got);
+            ret.push_back(static_cast<char>(buf));
+        }
+        return ret;
+    }
+
+    //--------------------------------------------------------------------------
+    std::string lines_text()
+    {
+        std::string ret;
+        for (size_t iter = 0; iter < 20000; ++iter) {
+            ret += "line " + std::to_string(iter % 13) + "\n";
+        }
+        return ret;
+    }
+
+    //--------------------------------------------------------------------------
+    std::vector<uint8_t> stored_stream(const uint8_t* data, size_t size)
+    {
+        std::vector<uint8_t> ret;
+        do {
+            auto chunk = static_cast<uint16_t>(std::min<size_t>(size, 0xFFFF));
+            size -= chunk;
+            ret.push_back(size == 0 ? 1 : 0);
+            ret.push_back(static_cast<uint8_t>(chunk));
+            ret.push_back(static_cast<uint8_t>(chunk >> 8));
+            ret.push_back(static_cast<uint8_t>(~chunk));
+            ret.push_back(static_cast<uint8_t>(~chunk >> 8));
+            ret.insert(ret.end(), data, data + chunk);
+            data += chunk;
+        } while (size > 0);
+        return ret;
+    }
+
+    const std::vector<uint8_t> dynamic_zlib = {
+        0x78, 0xDA, 0xB5, 0xCB, 0x55, 0x12, 0x83, 0x30, 0x14, 0x85, 0xE1, 0xAD,
+        0xDC, 0x15, 0x74, 0xEA, 0x46, 0xDD, 0xDD, 0xDD, 0x91, 0x00, 0xA1, 0x40,
+        0x20, 0x10, 0x6C, 0xF5, 0xCD, 0x74, 0x05, 0x7D, 0xE9, 0xE3, 0x99, 0xFF,
+        0x3B, 0xBE, 0x8E, 0xC0, 0x65, 0x58, 0x7E, 0x83, 0x44, 0x49, 0x68, 0x83,
+        0x4A, 0x22, 0x30, 0x98, 0xE5, 0x78, 0x40, 0x02, 0x44, 0xC1, 0xE7, 0xD9,
+        0x14, 0x93, 0x18, 0x14, 0xA2, 0x09, 0xDF, 0xF5, 0x1F, 0xEC, 0x88, 0xDC,
+        0x59, 0x31, 0x48, 0x1C, 0x85, 0xD8, 0xD7, 0x41, 0xC5, 0x01, 0xE2, 0x29,
+        0x41, 0x36, 0x98, 0xD8, 0x65, 0x84, 0xF2, 0xAF, 0xE6, 0xA5, 0x7E, 0x87,
+        0xE9, 0x4C, 0x36, 0x97, 0x2F, 0x14, 0x4B, 0xE5, 0x4A, 0x55, 0xA8, 0xD5,
+        0x1B, 0xCD, 0x56, 0xBB, 0xD3, 0xED, 0xF5, 0x07, 0xC3, 0xD1, 0x78, 0x32,
+        0x9D, 0xCD, 0x17, 0xCB, 0xD5, 0x7A, 0xB3, 0xDD, 0xED, 0x0F, 0xC7, 0xD3,
+        0xF9, 0x72, 0xBD, 0xDD, 0x1F, 0xCF, 0x97, 0x28, 0xC9, 0x0A, 0x52, 0x35,
+        0x1D, 0x1B, 0x6F, 0xD3, 0xB2, 0x89, 0xE3, 0x52, 0xCF, 0x67, 0x41, 0x18,
+        0xC5, 0xC9, 0x07, 0xE0, 0xB2, 0x67, 0x92
+    };
+
+    const std::vector<uint8_t> lines_zlib = {
+        0x78, 0xDA, 0xED, 0xCC, 0xAB, 0x0D, 0x80, 0x40, 0x00, 0x05, 0x41, 0x4F,
+        0x15, 0x94, 0xC0, 0xF1, 0xA7, 0x20, 0x04, 0xC9, 0x85, 0xFE, 0x25, 0x21,
+        0xEF, 0xF0, 0x14, 0x30, 0x6A, 0xD5, 0x4E, 0xBD, 0xEE, 0xB3, 0x1F, 0xBA,
+        0xFA, 0xA6, 0x24, 0x63, 0x32, 0x25, 0x73, 0xB2, 0x24, 0x6B, 0xB2, 0x25,
+        0x7B, 0x72, 0xB4, 0xFD, 0x63, 0x9A, 0x53, 0x1A, 0x44, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A,
+        0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A,
+        0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A,
+        0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A,
+        0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A,
+        0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9,
+        0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7,
+        0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D,
+        0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74,
+        0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3,
+        0xE9, 0x74, 0x3A, 0x9D, 0x4E, 0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0x4E,
+        0xA7, 0xD3, 0xE9, 0x74, 0x3A, 0x9D, 0xFE, 0x43, 0x7F, 0x00, 0x89, 0xBB,
+        0x79, 0x45
+    };
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, storedRaw)
+{
+    auto src = make_inflate({0x01, 0x06, 0x00, 0xF9, 0xFF, 's', 't', 'o', 'r', 'e', 'd'});
+    EXPECT_TRUE(src->depleted());
+    EXPECT_EQ("stored", inflate_all(*src));
+    EXPECT_TRUE(src->finished());
+
+    uint64_t buf = 0;
+    EXPECT_ANY_THROW(src->get_n(buf, 1));
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, fixedHuffmanRaw)
+{
+    auto src = make_inflate({0x4B, 0x4C, 0x4A, 0x4E, 0x84, 0x21, 0x00});
+    EXPECT_EQ("abcabcabcabc", inflate_all(*src));
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, dynamicHuffmanZlib)
+{
+    std::string expected;
+    for (int iter = 0; iter < 3; ++iter) {
+        expected += "the quick brown fox jumps over the lazy dog; ";
+    }
+    for (int iter = 0; iter < 2; ++iter) {
+        expected += "pack my box with five dozen liquor jugs. ";
+    }
+    for (char ch = 48; ch < 123; ++ch) {
+        expected.push_back(ch);
+    }
+
+    auto src = make_inflate(dynamic_zlib);
+    EXPECT_EQ(expected, inflate_all(*src));
+    EXPECT_TRUE(src->finished());
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, zlibChecksumMismatch)
+{
+    auto broken = dynamic_zlib;
+    broken.back() ^= 0x01;
+
+    auto src = make_inflate(broken);
+    EXPECT_THROW(inflate_all(*src), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, gzipMultiMember)
+{
+    const std::vector<uint8_t> members = {
+        0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4B, 0xCB,
+        0x2C, 0x2A, 0x2E, 0x51, 0x00, 0x00, 0xFC, 0x7A, 0xF1, 0x1C, 0x06, 0x00,
+        0x00, 0x00,
+        0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x2B, 0x4E,
+        0x4D, 0xCE, 0xCF, 0x4B, 0x01, 0x00, 0x69, 0x11, 0x1F, 0xB6, 0x06, 0x00,
+        0x00, 0x00
+    };
+
+    auto src = make_inflate(members);
+    EXPECT_EQ("first second", inflate_all(*src));
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, gzipOptionalFields)
+{
+    // FEXTRA "xyz", FNAME "a.txt"
+    const std::vector<uint8_t> named = {
+        0x1F, 0x8B, 0x08, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00,
+        0x78, 0x79, 0x7A, 0x61, 0x2E, 0x74, 0x78, 0x74, 0x00, 0xCB, 0x4B, 0xCC,
+        0x4D, 0x4D, 0x01, 0x00, 0x87, 0xCC, 0xE0, 0x71, 0x05, 0x00, 0x00, 0x00
+    };
+
+    auto src = make_inflate(named, inflate_source::format::gzip);
+    EXPECT_EQ("named", inflate_all(*src));
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, invalidData)
+{
+    // Block type 3 is reserved
+    auto src = make_inflate({0x07, 0x00}, inflate_source::format::raw);
+    EXPECT_THROW(src->available(), std::runtime_error);
+
+    // Truncated stored block
+    src = make_inflate({0x01, 0x06, 0x00, 0xF9, 0xFF, 's', 't'});
+    EXPECT_THROW(inflate_all(*src), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, slidingWindow)
+{
+    const auto expected = lines_text();
+    auto src = make_inflate(lines_zlib);
+
+    std::string actual;
+    uint64_t buf = 0;
+    while (src->available() > 0) {
+        buf = 0;
+        auto got = src->get_n(buf, 8);
+        for (size_t iter = got; iter > 0; --iter) {
+            actual.push_back(static_cast<char>(buf >> (8 * (iter - 1))));
+        }
+    }
+
+    EXPECT_EQ(expected, actual);
+    EXPECT_TRUE(src->finished());
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, seekAndClone)
+{
+    const size_t size = 200 * 1024;
+    std::unique_ptr<uint8_t[]> data{generate_test_data(size)};
+    auto src = make_inflate(stored_stream(data.get(), size), inflate_source::format::raw);
+
+    auto check = [&] (uint64_t position) {
+        uint64_t buf = 0;
+        EXPECT_EQ(position, src->position());
+        EXPECT_EQ(1, src->get_n(buf, 1));
+        EXPECT_EQ(data[position], buf);
+    };
+
+    // Forward beyond the window, back inside it, then back past it
+    src->seek(150000);
+    check(150000);
+    src->seek(140000);
+    check(140000);
+    src->seek(10);
+    check(10);
+
+    src->skip(100000);
+    auto copy = src->clone();
+    check(100011);
+    uint64_t buf = 0;
+    copy->get_n(buf, 1);
+    EXPECT_EQ(data[100011], buf);
+
+    src->seek(size);
+    EXPECT_EQ(0, src->available());
+    EXPECT_THROW(src->seek(size + 1), std::range_error);
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, failedSeekKeepsPosition)
+{
+    const size_t size = 200 * 1024;
+    std::unique_ptr<uint8_t[]> data{generate_test_data(size)};
+    auto src = make_inflate(stored_stream(data.get(), size), inflate_source::format::raw);
+
+    // Decoding to the end slides the window past the old position
+    src->seek(10);
+    EXPECT_THROW(src->seek(size + 1), std::range_error);
+    EXPECT_EQ(10, src->position());
+    uint64_t buf = 0;
+    EXPECT_EQ(1, src->get_n(buf, 1));
+    EXPECT_EQ(data[10], buf);
+
+    src->seek(150000);
+    EXPECT_THROW(src->skip(size), std::range_error);
+    EXPECT_EQ(150000, src->position());
+    buf = 0;
+    EXPECT_EQ(1, src->get_n(buf, 1));
+    EXPECT_EQ(data[150000], buf);
+}
+
+//------------------------------------------------------------------------------
+TEST(inflateByteSourceTest, bitreader)
+{
+    const auto expected = lines_text();
+    auto src = make_inflate(lines_zlib);
+    brcpp::bitreader<inflate_source> br(src);
+
+    EXPECT_EQ(uint32_t('l'), br.read<uint32_t>(8));
+
+    // Skip far beyond what the source has decoded so far
+    const size_t target = 100000;
+    br.skip((target - 1) * 8);
+    EXPECT_EQ(target * 8, br.position());
+    EXPECT_EQ(uint8_t(expected[target]), br.read<uint8_t>(8));
+    EXPECT_EQ(uint8_t(expected[target + 1]), br.read<uint8_t>(8));
+
+    br.skip(8 * (expected.size() - target - 2));
+    EXPECT_EQ(0, br.available());
+    EXPECT_ANY_THROW(br.read<uint8_t>(8));
+}
@@ -121,3 +121,73 @@ TEST(memoryByteSourceTest, clone)
     EXPECT_EQ(1, clone->get_n(buf2, 1));
     EXPECT_EQ(buf1, buf2);
 }
+
+//------------------------------------------------------------------------------
+TEST(memoryByteSourceTest, borrow)
+{
+    const size_t size = 10;
+    std::unique_ptr<std::uint8_t[]> data{generate_test_data(size)};
+    memory_byte_source src(borrow_memory, data.get(), size);
+
+    check_get(src, 1, 1);
+    data[1] = 0xAB;
+    check_get(src, 0xAB, 1);
+    EXPECT_EQ(size-2, src.available());
+
+    auto clone = src.clone();
+    EXPECT_EQ(2, clone->position());
+    data[2] = 0xCD;
+    check_get(*clone, 0xCD, 1);
+    check_get(src, 0xCD, 1);
+}
+
+//------------------------------------------------------------------------------
+TEST(memoryByteSourceTest, adopt)
+{
+    const size_t size = 10;
+    auto buffer = shared_buffer::wrap_mem(generate_test_data(size), size);
+    memory_byte_source src(buffer);
+
+    buffer.get()[0] = 0xAB;
+    check_get(src, 0xAB, 1);
+    EXPECT_EQ(size-1, src.available());
+
+    auto clone = src.clone();
+    EXPECT_EQ(src.position(), clone->position());
+    EXPECT_EQ(src.available(), clone->available());
+    check_get(*clone, 2, 1);
+}
+
+//------------------------------------------------------------------------------
+TEST(memoryByteSourceTest, adoptOutlivesBuffer)
+{
+    const size_t size = 10;
+    std::shared_ptr<memory_byte_source> src;
+    {
+        auto buffer = shared_buffer::wrap_mem(generate_test_data(size), size);
+        src = std::make_shared<memory_byte_source>(buffer);
+    }
+
+    src->seek(size-1);
+    check_get(*src, size, 1);
+}
+
+//------------------------------------------------------------------------------
+TEST(memoryByteSourceTest, cloneSharesStorage)
+{
+    const size_t size = 10;
+    auto buffer = shared_buffer::wrap_mem(generate_test_data(size), size);
+    memory_byte_source src(buffer);
+    src.seek(3);
+
+    auto clone = src.clone();
+    auto nested = clone->clone();
+    buffer.get()[3] = 0xEE;
+    check_get(src, 0xEE, 1);
+    check_get(*clone, 0xEE, 1);
+    check_get(*nested, 0xEE, 1);
+
+    src.seek(0);
+    EXPECT_EQ(4, clone->position());
+    EXPECT_EQ(size-4, nested->available());
+}
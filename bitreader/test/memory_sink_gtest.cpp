@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/bitwriter.hpp"
+#include "bitreader/data_sink/memory_sink.hpp"
+#include "bitreader/data_source/memory_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, put)
+{
+    memory_sink sink(4);
+    for (size_t iter = 0; iter < 1000; ++iter) {
+        sink.put(static_cast<uint8_t>(iter), 8);
+    }
+
+    EXPECT_EQ(1000, sink.position());
+    EXPECT_GE(sink.capacity(), 1000);
+    EXPECT_EQ(0, sink.data()[0]);
+    EXPECT_EQ(static_cast<uint8_t>(999), sink.data()[999]);
+}
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, windowAndCommit)
+{
+    memory_sink sink(16);
+    auto window = sink.window(8);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(window) % memory_sink::BufferAlignment);
+    window[0] = 1;
+    window[1] = 2;
+    sink.commit(2);
+    EXPECT_EQ(2, sink.position());
+    EXPECT_EQ(window + 2, sink.window(4));
+
+    EXPECT_THROW(sink.commit(100), std::range_error);
+
+    // A larger window grows the buffer and keeps the data
+    window = sink.window(100);
+    window[0] = 3;
+    sink.commit(1);
+    EXPECT_EQ(3, sink.position());
+    EXPECT_EQ(1, sink.data()[0]);
+    EXPECT_EQ(3, sink.data()[2]);
+}
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, reserve)
+{
+    memory_sink sink;
+    sink.reserve(100000);
+    EXPECT_EQ(100000, sink.capacity());
+
+    auto data = sink.data();
+    for (size_t iter = 0; iter < 100000; ++iter) {
+        sink.put(0xAB, 8);
+    }
+    EXPECT_EQ(data, sink.data());
+}
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, finish)
+{
+    counting_resource resource;
+    memory_sink sink(16, &resource);
+    sink.put(1, 8);
+    sink.put(2, 8);
+    auto data = sink.data();
+
+    auto out = sink.finish();
+    EXPECT_EQ(data, out.get());
+    EXPECT_EQ(2, out.size());
+    EXPECT_EQ(&resource, out.resource());
+    EXPECT_EQ(0, sink.position());
+
+    // The sink starts over with a buffer of its own
+    sink.put(3, 8);
+    EXPECT_NE(data, sink.data());
+    EXPECT_EQ(1, out[0]);
+    EXPECT_EQ(2, resource.live());
+}
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, bitwriter)
+{
+    auto sink = std::make_shared<memory_sink>(4);
+    bitwriter w(sink);
+    static_assert(decltype(w)::word_writes);
+
+    for (uint32_t iter = 0; iter < 1000; ++iter) {
+        w.write(iter, 13);
+    }
+    w.flush();
+
+    auto out = sink->finish();
+    EXPECT_EQ((1000 * 13 + 7) / 8, out.size());
+
+    auto source = std::make_shared<memory_byte_source>(out);
+    bitreader<memory_byte_source> r(source);
+    for (uint32_t iter = 0; iter < 1000; ++iter) {
+        ASSERT_EQ(iter, r.read<uint32_t>(13));
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(memorySinkTest, patch)
+{
+    auto sink = std::make_shared<memory_sink>(16);
+    bitwriter w(sink);
+
+    // Count prefix filled in once the records are written
+    w.write(1, 1);
+    auto count = w.reserve(15);
+    uint32_t records = 0;
+    for (; records < 500; ++records) {
+        w.write(records, 11);
+    }
+    w.patch(count, records);
+    w.flush();
+
+    const uint8_t patch[] = {0xFF, 0xFF};
+    EXPECT_THROW(sink->write_at(sink->position() - 1, patch, 2), std::range_error);
+    EXPECT_THROW(sink->merge_at(sink->position(), patch, patch, 1), std::range_error);
+
+    auto source = std::make_shared<memory_byte_source>(sink->finish());
+    bitreader<memory_byte_source> r(source);
+    EXPECT_EQ(1, r.read<uint8_t>(1));
+    ASSERT_EQ(500, r.read<uint32_t>(15));
+    for (uint32_t iter = 0; iter < 500; ++iter) {
+        ASSERT_EQ(iter & 0x7FF, r.read<uint32_t>(11));
+    }
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "bitreader/bitwriter.hpp"
+#include "bitreader/data_sink/mmap_sink.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+namespace {
+    //--------------------------------------------------------------------------
+    class mmapSinkTest: public ::testing::Test
+    {
+    protected:
+        void TearDown() override
+        {
+            std::remove(_path.c_str());
+        }
+
+        std::vector<uint8_t> contents() const
+        {
+            std::ifstream file(_path, std::ios::binary);
+            return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        }
+
+        std::string _path = temp_path("mmap_sink_gtest");
+    };
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, growAndTruncate)
+{
+    mmap_sink sink(_path, 1);
+    EXPECT_LE(1, sink.capacity());
+
+    std::vector<uint8_t> expected;
+    for (size_t iter = 0; iter < 100000; ++iter) {
+        auto value = static_cast<uint8_t>(iter * 13);
+        sink.put(value, 8);
+        expected.push_back(value);
+    }
+
+    EXPECT_EQ(100000, sink.position());
+    EXPECT_GE(sink.capacity(), 100000);
+    EXPECT_EQ(expected[99999], sink.data()[99999]);
+
+    sink.close();
+    EXPECT_EQ(expected, contents());
+    EXPECT_THROW(sink.put(1, 8), std::runtime_error);
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, reserve)
+{
+    mmap_sink sink(_path);
+    sink.reserve(10 * mmap_sink::DefaultCapacity);
+    auto data = sink.data();
+    auto window = sink.window(5 * mmap_sink::DefaultCapacity);
+    EXPECT_EQ(data, window);
+    sink.commit(5 * mmap_sink::DefaultCapacity);
+    EXPECT_EQ(data, sink.data());
+    EXPECT_THROW(sink.commit(6 * mmap_sink::DefaultCapacity), std::range_error);
+
+    sink.close();
+    EXPECT_EQ(5 * mmap_sink::DefaultCapacity, contents().size());
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, bitwriter)
+{
+    auto sink = std::make_shared<mmap_sink>(_path, 4096);
+    bitwriter w(sink);
+    static_assert(decltype(w)::word_writes);
+
+    for (uint32_t iter = 0; iter < 10000; ++iter) {
+        w.write(iter, 17);
+    }
+    w.flush();
+
+    const uint8_t patch[] = {0xAB, 0xCD};
+    sink->write_at(0, patch, 2);
+    EXPECT_THROW(sink->write_at(sink->position() - 1, patch, 2), std::range_error);
+    sink->sync();
+    sink->close();
+
+    auto data = contents();
+    ASSERT_EQ((10000 * 17 + 7) / 8, data.size());
+    EXPECT_EQ(0xAB, data[0]);
+    EXPECT_EQ(0xCD, data[1]);
+    EXPECT_EQ(0x40, data[4]);   // 1 ends at bit 33
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, patch)
+{
+    auto sink = std::make_shared<mmap_sink>(_path, 4096);
+    bitwriter w(sink);
+
+    w.write(0, 5);
+    auto field = w.reserve(24);
+    for (uint32_t iter = 0; iter < 10000; ++iter) {
+        w.write(~0u, 17);
+    }
+    w.patch(field, 0xC0FFEE);
+    w.flush();
+    sink->close();
+
+    auto data = contents();
+    ASSERT_EQ((5 + 24 + 10000 * 17 + 7) / 8, data.size());
+    EXPECT_EQ(0x06, data[0]);   // 00000 then 1100 0000 1111 1111 1110 1110
+    EXPECT_EQ(0x07, data[1]);
+    EXPECT_EQ(0xFF, data[2]);
+    EXPECT_EQ(0x77, data[3]);
+    EXPECT_EQ(0xFF, data[4]);
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, writeAfterClose)
+{
+    auto sink = std::make_shared<mmap_sink>(_path);
+    bitwriter w(sink);
+    auto field = w.reserve(16);
+    w.write(0xABCD, 16);
+    w.flush();
+    sink->close();
+
+    const uint8_t patch[] = {1, 2};
+    EXPECT_THROW(sink->write_at(0, patch, 2), std::runtime_error);
+    EXPECT_THROW(sink->merge_at(0, patch, patch, 2), std::runtime_error);
+    EXPECT_THROW(w.patch(field, 0x1234), std::runtime_error);
+    EXPECT_THROW(sink->put(1, 8), std::runtime_error);
+    EXPECT_EQ(std::vector<uint8_t>({0, 0, 0xAB, 0xCD}), contents());
+}
+
+//------------------------------------------------------------------------------
+TEST_F(mmapSinkTest, openFailure)
+{
+    EXPECT_THROW(mmap_sink("/nonexistent/dir/file.bin"), std::runtime_error);
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/multi_file_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+namespace {
+    template<typename Source>
+    void check_get(Source& src, uint64_t val, size_t read)
+    {
+        uint64_t buf = 0;
+        EXPECT_EQ(read, src.get_n(buf, read));
+        EXPECT_EQ(buf, val);
+    }
+
+    std::vector<std::shared_ptr<file_reader>> make_readers(std::initializer_list<size_t> sizes)
+    {
+        std::vector<std::shared_ptr<file_reader>> ret;
+        for (auto size: sizes) {
+            ret.push_back(std::make_shared<fake_file_reader>(size));
+        }
+        return ret;
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, empty)
+{
+    multi_file_byte_source src(make_readers({}));
+    uint64_t buf = 0;
+    EXPECT_EQ(0, src.available());
+    EXPECT_TRUE(src.depleted());
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+    EXPECT_NO_THROW(src.seek(0));
+    EXPECT_ANY_THROW(src.seek(1));
+    EXPECT_ANY_THROW(src.skip(1));
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, crossFiles)
+{
+    multi_file_byte_source src(make_readers({3, 0, 2, 4}));
+    EXPECT_EQ(9, src.available());
+
+    check_get(src, 0x0102, 2);
+    check_get(src, 0x03010201, 4);
+    EXPECT_EQ(3, src.segment());
+    EXPECT_EQ(6, src.position());
+    uint64_t buf = 0;
+    EXPECT_EQ(3, src.get_n(buf, 8));
+    EXPECT_EQ(0x020304, buf);
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, seek)
+{
+    multi_file_byte_source src(make_readers({3, 0, 2, 4}));
+    const uint64_t expected[] = {1, 2, 3, 1, 2, 1, 2, 3, 4};
+    for (uint64_t pos = 0; pos < 9; ++pos) {
+        src.seek(pos);
+        EXPECT_EQ(pos, src.position());
+        EXPECT_EQ(9 - pos, src.available());
+        check_get(src, expected[pos], 1);
+    }
+
+    src.seek(9);
+    EXPECT_EQ(0, src.available());
+    EXPECT_ANY_THROW(src.seek(10));
+
+    src.seek(1);
+    src.skip(4);
+    check_get(src, 1, 1);
+
+    auto clone = src.clone();
+    EXPECT_EQ(src.position(), clone->position());
+    check_get(*clone, 2, 1);
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, prefetchNearBoundary)
+{
+    const size_t size = 1024 * 1024;
+    auto first = std::make_shared<fake_file_reader>(size);
+    auto second = std::make_shared<fake_file_reader>(size);
+    multi_file_byte_source src({first, second});
+
+    uint64_t buf = 0;
+    src.get_n(buf, 8);
+    EXPECT_EQ(0, second->prefetches());
+
+    src.seek(size - multi_file_byte_source::PrefetchDistance / 2);
+    src.get_n(buf, 8);
+    EXPECT_EQ(1, second->prefetches());
+    src.get_n(buf, 8);
+    EXPECT_EQ(1, second->prefetches());
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, backAndForth)
+{
+    auto first = std::make_shared<fake_file_reader>(1000);
+    auto second = std::make_shared<fake_file_reader>(1000);
+    multi_file_byte_source src({first, second});
+
+    src.seek(998);
+    check_get(src, 0xE7E80102, 4);
+    auto reads = first->reads() + second->reads();
+    for (size_t iter = 0; iter < 10; ++iter) {
+        src.seek(999);
+        check_get(src, 0xE8, 1);
+        check_get(src, 0x01, 1);
+    }
+    EXPECT_EQ(reads, first->reads() + second->reads());
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, cloneOwnsReaders)
+{
+    auto first = std::make_shared<fake_file_reader>(3);
+    auto second = std::make_shared<fake_file_reader>(2);
+    multi_file_byte_source src({first, second});
+    check_get(src, 0x01, 1);
+    auto reads = first->reads() + second->reads();
+
+    auto clone = src.clone();
+    EXPECT_EQ(1, clone->position());
+    check_get(*clone, 0x02030102, 4);
+    EXPECT_EQ(0, clone->available());
+    EXPECT_EQ(reads, first->reads() + second->reads());
+
+    check_get(src, 0x02030102, 4);
+}
+
+//------------------------------------------------------------------------------
+TEST(multiFileByteSourceTest, reader)
+{
+    auto src = std::make_shared<multi_file_byte_source>(make_readers({1, 2, 3}));
+    bitreader<multi_file_byte_source> br(src);
+    EXPECT_EQ(0x010, br.read<uint16_t>(12));
+    EXPECT_EQ(0x1020102, br.read<uint32_t>(28));
+    EXPECT_EQ(8, br.available());
+    br.seek(8);
+    EXPECT_EQ(0x0102010203, br.read<uint64_t>(40));
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bitreader/common/odirect_file_reader.hpp"
+#include "bitreader/data_source/file_byte_source.hpp"
+#include "gtest_common.hpp"
+
+using namespace brcpp;
+
+namespace {
+    //--------------------------------------------------------------------------
+    class odirectFileReaderTest: public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            _path = temp_path("odirect_file_reader_gtest");
+            _data.resize(3*4096 + 123);
+            for (size_t iter = 0; iter < _data.size(); ++iter) {
+                _data[iter] = static_cast<uint8_t>(iter * 7);
+            }
+
+            FILE* file = fopen(_path.c_str(), "wb");
+            ASSERT_NE(nullptr, file);
+            ASSERT_EQ(_data.size(), fwrite(_data.data(), 1, _data.size(), file));
+            fclose(file);
+
+            try {
+                _reader = odirect_file_reader::open(_path);
+            } catch (const std::exception&) {
+                GTEST_SKIP() << "O_DIRECT is not supported by this filesystem";
+            }
+        }
+
+        void TearDown() override
+        {
+            _reader.reset();
+            std::remove(_path.c_str());
+        }
+
+        std::string _path;
+        std::vector<uint8_t> _data;
+        std::shared_ptr<file_reader> _reader;
+    };
+}
+
+//------------------------------------------------------------------------------
+TEST_F(odirectFileReaderTest, size)
+{
+    EXPECT_EQ(_data.size(), _reader->size());
+    EXPECT_EQ(odirect_file_reader::DefaultAlignment, _reader->alignment());
+    EXPECT_TRUE(_reader->depleted());
+}
+
+//------------------------------------------------------------------------------
+TEST_F(odirectFileReaderTest, unalignedRead)
+{
+    std::vector<uint8_t> out(5000);
+    EXPECT_EQ(out.size(), _reader->read(out.data(), 1001, out.size()));
+    EXPECT_TRUE(std::equal(out.begin(), out.end(), _data.begin() + 1001));
+
+    EXPECT_EQ(23, _reader->read(out.data(), _data.size() - 23, out.size()));
+    EXPECT_TRUE(std::equal(out.begin(), out.begin() + 23, _data.end() - 23));
+    EXPECT_EQ(0, _reader->read(out.data(), _data.size(), out.size()));
+}
+
+//------------------------------------------------------------------------------
+TEST_F(odirectFileReaderTest, byteSource)
+{
+    file_byte_source src(_reader);
+    src.seek(4095);
+    uint64_t buf = 0;
+    EXPECT_EQ(2, src.get_n(buf, 2));
+    EXPECT_EQ((static_cast<uint64_t>(_data[4095]) << 8) | _data[4096], buf);
+
+    auto clone = src.clone();
+    EXPECT_EQ(src.available(), clone->available());
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/pipe_byte_source.hpp"
+#include "gtest_common.hpp"
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    std::string test_string(size_t size)
+    {
+        std::unique_ptr<uint8_t[]> data{generate_test_data(size)};
+        return std::string(reinterpret_cast<const char*>(data.get()), size);
+    }
+
+    //--------------------------------------------------------------------------
+    uint8_t test_byte(uint64_t position)
+    {
+        return static_cast<uint8_t>(position + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, empty)
+{
+    std::istringstream stream;
+    pipe_byte_source src(stream);
+
+    uint64_t buf = 0;
+    EXPECT_TRUE(src.depleted());
+    EXPECT_EQ(0, src.available());
+    EXPECT_EQ(0, src.size().value());
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+    EXPECT_NO_THROW(src.seek(0));
+    EXPECT_ANY_THROW(src.seek(1));
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, sequential)
+{
+    const size_t size = 300 * 1024;
+    std::istringstream stream(test_string(size));
+    pipe_byte_source src(stream, 1024);
+
+    EXPECT_FALSE(src.size().has_value());
+    for (uint64_t position = 0; position < size; position += 8) {
+        uint64_t buf = 0;
+        ASSERT_EQ(8, src.get_n(buf, 8));
+        ASSERT_EQ(test_byte(position + 7), static_cast<uint8_t>(buf));
+    }
+
+    EXPECT_EQ(0, src.available());
+    EXPECT_EQ(size, src.size().value());
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, lookBehind)
+{
+    const size_t size = 500 * 1024;
+    std::istringstream stream(test_string(size));
+    pipe_byte_source src(stream, 4096);
+
+    uint64_t buf = 0;
+    src.seek(200 * 1024);
+    EXPECT_EQ(200 * 1024, src.position());
+    src.get_n(buf, 1);
+    EXPECT_EQ(test_byte(200 * 1024), buf);
+
+    // Within the look-behind window
+    src.seek(200 * 1024 - 4000);
+    buf = 0;
+    src.get_n(buf, 1);
+    EXPECT_EQ(test_byte(200 * 1024 - 4000), buf);
+
+    // Skipping forward reads through, older data is gone
+    src.skip(200 * 1024);
+    const auto position = src.position();
+    EXPECT_THROW(src.seek(100), std::range_error);
+    EXPECT_THROW(src.seek(size + 1), std::range_error);
+    EXPECT_EQ(position, src.position());
+    EXPECT_THROW(src.get_n(buf, 1), std::range_error);
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, failedSeekKeepsPosition)
+{
+    const size_t size = 10000;
+    std::istringstream stream(test_string(size));
+    pipe_byte_source src(stream);
+
+    src.seek(1234);
+    EXPECT_THROW(src.seek(size + 1), std::range_error);
+    EXPECT_THROW(src.skip(size), std::range_error);
+    EXPECT_EQ(1234, src.position());
+
+    uint64_t buf = 0;
+    EXPECT_EQ(1, src.get_n(buf, 1));
+    EXPECT_EQ(test_byte(1234), buf);
+    EXPECT_EQ(size, src.size().value());
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, bitreader)
+{
+    const size_t size = 100 * 1024;
+    std::istringstream stream(test_string(size));
+    auto src = std::make_shared<pipe_byte_source>(stream, 1024);
+    bitreader<pipe_byte_source> br(src);
+
+    EXPECT_EQ(0x0102, br.peek<uint16_t>(16));
+    EXPECT_EQ(0x01, br.read<uint8_t>(8));
+
+    // The reader cannot know the size, yet can skip well past what is buffered
+    br.skip(8 * 50000);
+    EXPECT_EQ(test_byte(50001), br.read<uint8_t>(8));
+
+    br.skip(8 * (size - 50002));
+    EXPECT_EQ(0, br.available());
+    EXPECT_THROW(br.read<uint8_t>(8), std::runtime_error);
+}
+
+#ifndef WIN32
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, fileDescriptor)
+{
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+
+    const size_t size = 200 * 1024;
+    const auto data = test_string(size);
+    std::thread writer([&] {
+        // Small writes, so the reader sees the data trickle in
+        for (size_t offset = 0; offset < size; offset += 1000) {
+            auto chunk = std::min<size_t>(1000, size - offset);
+            EXPECT_EQ(static_cast<ssize_t>(chunk), ::write(fds[1], data.data() + offset, chunk));
+        }
+        ::close(fds[1]);
+    });
+
+    auto src = std::make_shared<pipe_byte_source>(fds[0]);
+    bitreader<pipe_byte_source> br(src);
+    size_t position = 0;
+    while (br.available() > 0) {
+        ASSERT_EQ(test_byte(position), br.read<uint8_t>(8));
+        ++position;
+    }
+
+    writer.join();
+    ::close(fds[0]);
+    EXPECT_EQ(size, position);
+    EXPECT_EQ(size, src->size().value());
+}
+
+//------------------------------------------------------------------------------
+TEST(pipeByteSourceTest, fewBytesPending)
+{
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+
+    // Only three bytes arrive until the reader has used them, or until
+    // the writer gives up on it
+    const uint8_t data[] = {0x12, 0x34, 0x56};
+    std::atomic<bool> done{false};
+    std::atomic<bool> closed{false};
+    std::thread writer([&] {
+        EXPECT_EQ(static_cast<ssize_t>(sizeof(data)), ::write(fds[1], data, sizeof(data)));
+        for (size_t iter = 0; iter < 500 && !done; ++iter) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        closed = true;
+        ::close(fds[1]);
+    });
+
+    auto src = std::make_shared<pipe_byte_source>(fds[0]);
+    bitreader<pipe_byte_source> br(src);
+    EXPECT_EQ(0x1, br.read<uint8_t>(4));
+    EXPECT_EQ(0x23456, br.read<uint32_t>(20));
+    EXPECT_FALSE(closed);
+    done = true;
+
+    writer.join();
+    EXPECT_EQ(0, br.available());
+    ::close(fds[0]);
+}
+#endif
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/rbsp_byte_source.hpp"
+
+using namespace brcpp;
+
+namespace
+{
+    //--------------------------------------------------------------------------
+    std::vector<uint8_t> read_all(rbsp_byte_source& src, size_t chunk)
+    {
+        std::vector<uint8_t> ret;
+        while (src.available() > 0) {
+            uint64_t buf = 0;
+            auto got = src.get_n(buf, chunk);
+            for (size_t iter = got; iter > 0; --iter) {
+                ret.push_back(static_cast<uint8_t>(buf >> (8 * (iter - 1))));
+            }
+        }
+        return ret;
+    }
+
+    //--------------------------------------------------------------------------
+    void escape(const std::vector<uint8_t>& rbsp, std::vector<uint8_t>& escaped)
+    {
+        size_t zeros = 0;
+        for (auto byte : rbsp) {
+            if (zeros == 2 && byte <= 0x03) {
+                escaped.push_back(0x03);
+                zeros = 0;
+            }
+            escaped.push_back(byte);
+            zeros = byte == 0 ? zeros + 1 : 0;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, emptyCtor)
+{
+    rbsp_byte_source src;
+    uint64_t buf = 0;
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+    EXPECT_TRUE(src.depleted());
+    EXPECT_EQ(0, src.available());
+    EXPECT_NO_THROW(src.seek(0));
+    EXPECT_ANY_THROW(src.seek(1));
+    EXPECT_ANY_THROW(src.skip(1));
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, noEscapes)
+{
+    const uint8_t data[] = {0x00, 0x00, 0x01, 0x03, 0x00, 0x03};
+    rbsp_byte_source src(data, sizeof(data));
+
+    EXPECT_EQ(0, src.escapes());
+    EXPECT_EQ(std::vector<uint8_t>(data, data + sizeof(data)), read_all(src, 8));
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, stripsEscapes)
+{
+    const uint8_t data[] = {
+        0x25, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03,
+        0x00, 0x00, 0x03, 0x03, 0x7F, 0x00, 0x00, 0x03
+    };
+    const std::vector<uint8_t> expected = {
+        0x25, 0x00, 0x00, 0x01, 0x00, 0x00,
+        0x00, 0x00, 0x03, 0x7F, 0x00, 0x00
+    };
+
+    for (size_t chunk = 1; chunk <= 8; ++chunk) {
+        rbsp_byte_source src(borrow_memory, data, sizeof(data));
+        EXPECT_EQ(4, src.escapes());
+        EXPECT_EQ(expected.size(), src.available());
+        EXPECT_EQ(expected, read_all(src, chunk));
+        EXPECT_EQ(sizeof(data), src.original_position());
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, seekAndMapping)
+{
+    std::vector<uint8_t> rbsp;
+    for (size_t iter = 0; iter < 3000; ++iter) {
+        rbsp.push_back(iter % 5 == 0 ? 0x01 : 0x00);
+    }
+
+    std::vector<uint8_t> escaped;
+    escape(rbsp, escaped);
+    ASSERT_GT(escaped.size(), rbsp.size());
+
+    rbsp_byte_source src(shared_buffer::copy_mem(escaped.data(), escaped.size()));
+    EXPECT_EQ(escaped.size() - rbsp.size(), src.escapes());
+    EXPECT_EQ(rbsp.size(), src.available());
+
+    for (size_t position : {2999u, 0u, 1234u, 17u, 2000u, 3u}) {
+        src.seek(position);
+        EXPECT_EQ(position, src.position());
+
+        auto original = src.original_position(position);
+        EXPECT_EQ(original, src.original_position());
+        EXPECT_EQ(rbsp[position], escaped[original]);
+
+        uint64_t buf = 0;
+        EXPECT_EQ(1, src.get_n(buf, 1));
+        EXPECT_EQ(rbsp[position], buf);
+    }
+
+    src.seek(10);
+    auto copy = src.clone();
+    src.skip(100);
+    EXPECT_EQ(110, src.position());
+    EXPECT_EQ(10, copy->position());
+
+    auto tail = read_all(*copy, 7);
+    EXPECT_TRUE(std::equal(rbsp.begin() + 10, rbsp.end(), tail.begin(), tail.end()));
+
+    EXPECT_EQ(escaped.size(), src.original_position(rbsp.size()));
+    EXPECT_ANY_THROW(src.original_position(rbsp.size() + 1));
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, lazyScan)
+{
+    std::vector<uint8_t> rbsp;
+    for (size_t iter = 0; iter < 100000; ++iter) {
+        rbsp.push_back(iter % 7 < 3 ? 0x00 : static_cast<uint8_t>(iter % 4));
+    }
+
+    std::vector<uint8_t> escaped;
+    escape(rbsp, escaped);
+
+    // Only the start has been looked at, so less is known to be available
+    rbsp_byte_source src(borrow_memory, escaped.data(), escaped.size());
+    uint64_t buf = 0;
+    EXPECT_EQ(8, src.get_n(buf, 8));
+    EXPECT_GE(src.available(), 8);
+    EXPECT_LT(src.available(), rbsp.size() - 8);
+
+    // Seeking far ahead finds the escapes in between
+    src.seek(90000);
+    EXPECT_EQ(src.original_position(90000), src.original_position());
+    EXPECT_EQ(rbsp[90000], escaped[src.original_position()]);
+    EXPECT_THROW(src.seek(rbsp.size() + 1), std::range_error);
+    EXPECT_EQ(90000, src.position());
+
+    src.seek(0);
+    for (size_t chunk: {1u, 3u, 8u}) {
+        rbsp_byte_source copy(borrow_memory, escaped.data(), escaped.size());
+        EXPECT_EQ(rbsp, read_all(copy, chunk));
+    }
+    EXPECT_EQ(escaped.size() - rbsp.size(), src.escapes());
+    EXPECT_EQ(rbsp.size(), src.available());
+
+    // A bitreader skips lazily past what has been scanned
+    auto shared = std::make_shared<rbsp_byte_source>(borrow_memory, escaped.data(), escaped.size());
+    brcpp::bitreader<rbsp_byte_source> br(shared);
+    br.skip(8 * 99999);
+    EXPECT_EQ(rbsp[99999], br.read<uint8_t>(8));
+    EXPECT_EQ(0, br.available());
+}
+
+//------------------------------------------------------------------------------
+TEST(rbspByteSourceTest, bitreader)
+{
+    // Exp-Golomb values split by an escape, as in a slice header
+    const uint8_t data[] = {0x00, 0x00, 0x03, 0x01, 0x80};
+    auto src = std::make_shared<rbsp_byte_source>(data, sizeof(data));
+    brcpp::bitreader<rbsp_byte_source> br(src);
+
+    EXPECT_EQ(32, br.available());
+    EXPECT_EQ(0x0000, br.read<uint32_t>(16));
+    EXPECT_EQ(0x01, br.read<uint32_t>(8));
+    EXPECT_EQ(1, br.read<uint32_t>(1));
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "bitreader/bitreader.hpp"
+#include "bitreader/data_source/segmented_byte_source.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+namespace {
+    template<typename Source>
+    void check_get(Source& src, uint64_t val, size_t read)
+    {
+        uint64_t buf = 0;
+        EXPECT_EQ(read, src.get_n(buf, read));
+        EXPECT_EQ(buf, val);
+    }
+
+    std::vector<shared_buffer> make_segments(std::initializer_list<size_t> sizes)
+    {
+        std::vector<shared_buffer> ret;
+        uint8_t value = 1;
+        for (auto size: sizes) {
+            auto buffer = shared_buffer::allocate(size);
+            buffer.resize(size);
+            for (auto& byte: buffer) {
+                byte = value++;
+            }
+            ret.push_back(buffer);
+        }
+        return ret;
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(segmentedByteSourceTest, emptyCtor)
+{
+    segmented_byte_source src;
+    uint64_t buf = 0;
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+    EXPECT_TRUE(src.depleted());
+    EXPECT_EQ(0, src.available());
+    EXPECT_EQ(0, src.position());
+    EXPECT_NO_THROW(src.seek(0));
+    EXPECT_ANY_THROW(src.seek(1));
+    EXPECT_NO_THROW(src.skip(0));
+    EXPECT_ANY_THROW(src.skip(1));
+}
+
+//------------------------------------------------------------------------------
+TEST(segmentedByteSourceTest, crossBoundaries)
+{
+    segmented_byte_source src(make_segments({3, 0, 1, 5, 2}));
+    EXPECT_EQ(4, src.segments());
+    EXPECT_EQ(11, src.available());
+
+    check_get(src, 0x0102, 2);
+    check_get(src, 0x030405060708, 6);
+    EXPECT_EQ(8, src.position());
+    check_get(src, 0x090A0B, 3);
+    EXPECT_EQ(0, src.available());
+    uint64_t buf = 0;
+    EXPECT_ANY_THROW(src.get_n(buf, 1));
+}
+
+//------------------------------------------------------------------------------
+TEST(segmentedByteSourceTest, seekAndSkip)
+{
+    segmented_byte_source src(make_segments({3, 1, 5, 2}));
+    for (uint64_t pos = 0; pos < 11; ++pos) {
+        src.seek(pos);
+        EXPECT_EQ(pos, src.position());
+        check_get(src, pos + 1, 1);
+    }
+
+    src.seek(11);
+    EXPECT_EQ(0, src.available());
+    EXPECT_ANY_THROW(src.seek(12));
+
+    src.seek(1);
+    src.skip(2);
+    check_get(src, 4, 1);
+    src.skip(5);
+    check_get(src, 10, 1);
+    EXPECT_ANY_THROW(src.skip(2));
+    src.skip(1);
+    EXPECT_EQ(11, src.position());
+}
+
+//------------------------------------------------------------------------------
+TEST(segmentedByteSourceTest, cloneAndReader)
+{
+    auto segments = make_segments({1, 2, 3});
+    auto src = std::make_shared<segmented_byte_source>(segments);
+    src->seek(2);
+    auto clone = src->clone();
+    EXPECT_EQ(2, clone->position());
+    check_get(*clone, 0x030405, 3);
+    EXPECT_EQ(2, src->position());
+
+    src->seek(0);
+    bitreader<segmented_byte_source> br(src);
+    EXPECT_EQ(0x010, br.read<uint16_t>(12));
+    EXPECT_EQ(0x2030405, br.read<uint32_t>(28));
+    EXPECT_EQ(8, br.available());
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "bitreader/common/shared_buffer.hpp"
+#include "gtest_common.hpp"
 
 using namespace brcpp;
 
@@ -252,3 +253,241 @@ TEST(sharedBufferTest, allocate)
     EXPECT_NO_FATAL_FAILURE((void)buf.get()[0]);
     EXPECT_NO_FATAL_FAILURE((void)buf.get()[size-1]);
 }
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, allocateAligned)
+{
+    const size_t size = 100;
+    const size_t alignment = 4096;
+    auto buf = shared_buffer::allocate(size, alignment);
+    EXPECT_TRUE(buf);
+    EXPECT_EQ(0, buf.size());
+    EXPECT_EQ(size, buf.capacity());
+    EXPECT_EQ(alignment, buf.alignment());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % alignment);
+
+    buf.resize(size);
+    auto copy = shared_buffer::clone(buf);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(copy.get()) % alignment);
+
+    buf.realloc(size*50);
+    EXPECT_EQ(alignment, buf.alignment());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % alignment);
+
+    EXPECT_ANY_THROW(shared_buffer::allocate(size, 3));
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, sharedSize)
+{
+    auto buf1 = shared_buffer::allocate(8);
+    auto buf2 = buf1;
+    buf1.resize(5);
+    EXPECT_EQ(5, buf2.size());
+
+    // The last reference going away must not affect an independent buffer
+    auto buf3 = shared_buffer::clone(buf2);
+    buf1 = shared_buffer();
+    buf2 = std::move(buf1);
+    EXPECT_FALSE(buf2);
+    EXPECT_EQ(5, buf3.size());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, slice)
+{
+    const size_t size = 16;
+    auto data = create_test_data(size);
+    auto buf = shared_buffer::copy_mem(data, size);
+    delete[] data;
+
+    auto view = buf.slice(4, 8);
+    EXPECT_TRUE(view.is_slice());
+    EXPECT_FALSE(buf.is_slice());
+    EXPECT_EQ(buf.get() + 4, view.get());
+    EXPECT_EQ(8, view.size());
+    EXPECT_EQ(8, view.capacity());
+    EXPECT_EQ(4, view[0]);
+
+    // Slices of slices are relative to the view
+    auto nested = view.slice(2, 3);
+    EXPECT_EQ(buf.get() + 6, nested.get());
+    EXPECT_EQ(3, nested.size());
+
+    EXPECT_THROW(view.slice(4, 5), std::out_of_range);
+    EXPECT_THROW(view.slice(9, 0), std::out_of_range);
+    EXPECT_NO_THROW(view.slice(8, 0));
+
+    // The view keeps the data alive
+    buf = shared_buffer();
+    EXPECT_EQ(6, nested[0]);
+    EXPECT_EQ(11, view[7]);
+
+    // Shrinking narrows the view, growing detaches it
+    view.resize(2);
+    EXPECT_EQ(2, view.size());
+    auto before = view.get();
+    view.resize(10);
+    EXPECT_NE(before, view.get());
+    EXPECT_FALSE(view.is_slice());
+    EXPECT_EQ(10, view.size());
+    EXPECT_EQ(4, view[0]);
+    EXPECT_EQ(5, view[1]);
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, sliceAlignment)
+{
+    auto buf = shared_buffer::allocate(8192, 4096);
+    buf.resize(8192);
+    EXPECT_EQ(4096, buf.slice(4096, 100).alignment());
+    EXPECT_EQ(0, buf.slice(100, 100).alignment());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, memoryResource)
+{
+    counting_resource resource;
+    {
+        auto buf = shared_buffer::allocate(100, 64, &resource);
+        EXPECT_EQ(&resource, buf.resource());
+        EXPECT_EQ(1, resource.allocations());
+        EXPECT_EQ(64, resource.last_alignment());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % 64);
+
+        // Derived buffers stay with the resource
+        buf.resize(100);
+        auto copy = shared_buffer::clone(buf);
+        buf.resize(1000);
+        EXPECT_EQ(&resource, copy.resource());
+        EXPECT_EQ(&resource, buf.resource());
+        EXPECT_EQ(3, resource.allocations());
+        EXPECT_EQ(2, resource.live());
+
+        auto copied = shared_buffer::copy_mem(buf.get(), 10, &resource);
+        EXPECT_EQ(3, resource.live());
+    }
+    EXPECT_EQ(0, resource.live());
+
+    auto plain = shared_buffer::allocate(10);
+    EXPECT_EQ(std::pmr::get_default_resource(), plain.resource());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, geometricGrowth)
+{
+    auto buf = shared_buffer::allocate(4);
+    EXPECT_EQ(shared_buffer::DefaultGrowthFactor, buf.growth_factor());
+
+    size_t reallocations = 0;
+    for (size_t iter = 0; iter < 10000; ++iter) {
+        auto data = buf.get();
+        buf.resize(iter + 1);
+        buf.get()[iter] = static_cast<uint8_t>(iter);
+        reallocations += (data != buf.get());
+    }
+
+    EXPECT_EQ(10000, buf.size());
+    EXPECT_GE(buf.capacity(), 10000);
+    EXPECT_LT(reallocations, 20);
+    EXPECT_EQ(static_cast<uint8_t>(9999), buf[9999]);
+
+    buf.set_growth_factor(1.0);
+    buf.resize(buf.capacity() + 1);
+    EXPECT_EQ(buf.size(), buf.capacity());
+
+    EXPECT_THROW(buf.set_growth_factor(0.5), std::invalid_argument);
+
+    // Kept across realloc() and reserve()
+    buf.set_growth_factor(1.5);
+    buf.realloc(100);
+    EXPECT_EQ(1.5, buf.growth_factor());
+    buf.reserve(200);
+    EXPECT_EQ(1.5, buf.growth_factor());
+    buf.resize(200);
+    buf.resize(201);
+    EXPECT_EQ(300, buf.capacity());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, emptiedKeepsResource)
+{
+    counting_resource resource;
+    auto check_regrow = [&] (shared_buffer& buf) {
+        EXPECT_EQ(0, buf.capacity());
+        buf.resize(100);
+        EXPECT_EQ(&resource, buf.resource());
+        EXPECT_EQ(256, buf.alignment());
+        EXPECT_EQ(256, resource.last_alignment());
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(buf.get()) % 256);
+    };
+
+    {
+        auto taken = shared_buffer::allocate(64, 256, &resource);
+        auto storage = taken.take();
+        check_regrow(taken);
+
+        auto emptied = shared_buffer::allocate(64, 256, &resource);
+        emptied.realloc(0);
+        check_regrow(emptied);
+
+        auto moved = shared_buffer::allocate(64, 256, &resource);
+        auto target = std::move(moved);
+        check_regrow(moved);
+        EXPECT_EQ(6, resource.allocations());
+    }
+    EXPECT_EQ(0, resource.live());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, reserve)
+{
+    auto buf = shared_buffer::allocate(8, 64);
+    buf.resize(3);
+    buf.get()[2] = 42;
+
+    buf.reserve(4);
+    EXPECT_EQ(8, buf.capacity());
+
+    buf.reserve(1000);
+    EXPECT_EQ(1000, buf.capacity());
+    EXPECT_EQ(3, buf.size());
+    EXPECT_EQ(42, buf[2]);
+    EXPECT_EQ(64, buf.alignment());
+
+    // Growing within the reserved capacity keeps the data in place
+    auto data = buf.get();
+    buf.resize(1000);
+    EXPECT_EQ(data, buf.get());
+}
+
+//------------------------------------------------------------------------------
+TEST(sharedBufferTest, take)
+{
+    const size_t size = 16;
+    auto data = create_test_data(size);
+    auto buf = shared_buffer::copy_mem(data, size);
+    delete[] data;
+
+    auto ptr = buf.get();
+    auto copy = buf;
+    EXPECT_THROW(buf.take(), std::runtime_error);
+    copy = shared_buffer();
+
+    auto storage = buf.take();
+    EXPECT_EQ(ptr, storage.get());
+    EXPECT_EQ(5, storage[5]);
+    EXPECT_FALSE(buf);
+    EXPECT_EQ(0, buf.size());
+
+    EXPECT_EQ(nullptr, shared_buffer().take());
+
+    counting_resource resource;
+    auto owned = shared_buffer::allocate(100, 16, &resource).take();
+    EXPECT_EQ(1, resource.live());
+    owned.reset();
+    EXPECT_EQ(0, resource.live());
+
+    auto wrapped = shared_buffer::wrap_mem(new uint8_t[10], 10).take();
+    EXPECT_TRUE(wrapped);
+}
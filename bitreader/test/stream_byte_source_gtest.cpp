@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "bitreader/data_source/stream_byte_source.hpp"
+
+using namespace brcpp;
+
+//------------------------------------------------------------------------------
+namespace {
+    template<typename Source>
+    void check_get(Source& src, uint64_t val, size_t read)
+    {
+        uint64_t buf = 0;
+        EXPECT_EQ(read, src.get_n(buf, read));
+        EXPECT_EQ(buf, val);
+    }
+}
+
+//------------------------------------------------------------------------------
+TEST(streamByteSourceTest, emptyCtor)
+{
+    stream_byte_source src;
+    uint64_t buf = 0;
+    EXPECT_FALSE(src.depleted());
+    EXPECT_EQ(0, src.available());
+    EXPECT_THROW(src.get_n(buf, 1), need_more_data);
+    EXPECT_THROW(src.skip(1), need_more_data);
+    EXPECT_NO_THROW(src.seek(0));
+
+    src.finish();
+    EXPECT_TRUE(src.depleted());
+    EXPECT_THROW(src.get_n(buf, 1), std::range_error);
+    EXPECT_THROW(src.skip(1), std::range_error);
+    EXPECT_ANY_THROW(src.push(shared_buffer::allocate(1)));
+}
+
+//------------------------------------------------------------------------------
+TEST(streamByteSourceTest, chunks)
+{
+    const uint8_t first[] = {0x01, 0x02, 0x03};
+    const uint8_t second[] = {0x04};
+    const uint8_t third[] = {0x05, 0x06};
+
+    stream_byte_source src;
+    src.push(first, sizeof(first));
+    check_get(src, 0x01, 1);
+    EXPECT_EQ(2, src.available());
+
+    uint64_t buf = 0;
+    EXPECT_EQ(2, src.get_n(buf, 4));
+    EXPECT_EQ(0x0203, buf);
+    EXPECT_THROW(src.get_n(buf, 1), need_more_data);
+
+    src.push(second, sizeof(second));
+    src.push(third, sizeof(third));
+    EXPECT_EQ(3, src.available());
+    check_get(src, 0x040506, 3);
+    EXPECT_EQ(6, src.position());
+
+    src.seek(2);
+    check_get(src, 0x0304, 2);
+    src.skip(1);
+    check_get(src, 0x06, 1);
+}
+
+//------------------------------------------------------------------------------
+TEST(streamByteSourceTest, discardsConsumedChunks)
+{
+    const uint8_t chunk[16] = {};
+    stream_byte_source src(4);
+    for (size_t iter = 0; iter < 4; ++iter) {
+        src.push(chunk, sizeof(chunk));
+    }
+
+    src.seek(40);
+    EXPECT_EQ(32, src.buffered());
+    EXPECT_THROW(src.seek(31), std::range_error);
+    EXPECT_NO_THROW(src.seek(36));
+    EXPECT_THROW(src.seek(65), need_more_data);
+}
+
+//------------------------------------------------------------------------------
+TEST(streamByteSourceTest, clone)
+{
+    const uint8_t data[] = {0x01, 0x02, 0x03};
+    stream_byte_source src;
+    src.push(data, sizeof(data));
+    src.skip(1);
+
+    auto clone = src.clone();
+    check_get(*clone, 0x0203, 2);
+    EXPECT_EQ(1, src.position());
+    check_get(src, 0x02, 1);
+}